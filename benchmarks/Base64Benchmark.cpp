@@ -0,0 +1,161 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <docmala/Base64.h>
+
+using namespace std;
+
+namespace {
+const string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                            "abcdefghijklmnopqrstuvwxyz"
+                            "0123456789+/";
+
+// the encoder the html output used to build a string with, one character at a time
+string legacyEncode(const string& inputData) {
+    string        ret;
+    int           i = 0;
+    int           j = 0;
+    unsigned char char_array_3[3];
+    unsigned char char_array_4[4];
+
+    for (char data : inputData) {
+        char_array_3[i++] = static_cast<unsigned char>(data);
+        if (i == 3) {
+            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+            char_array_4[1] = static_cast<unsigned char>(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
+            char_array_4[2] = static_cast<unsigned char>(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
+            char_array_4[3] = char_array_3[2] & 0x3f;
+
+            for (i = 0; (i < 4); i++) {
+                ret += base64_chars[char_array_4[i]];
+            }
+            i = 0;
+        }
+    }
+
+    if (i != 0) {
+        for (j = i; j < 3; j++) {
+            char_array_3[j] = '\0';
+        }
+
+        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+        char_array_4[1] = static_cast<unsigned char>(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
+        char_array_4[2] = static_cast<unsigned char>(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
+        char_array_4[3] = char_array_3[2] & 0x3f;
+
+        for (j = 0; (j < i + 1); j++) {
+            ret += base64_chars[char_array_4[j]];
+        }
+
+        while ((i++ < 3)) {
+            ret += '=';
+        }
+    }
+
+    return ret;
+}
+
+// the per character scalar encoder, that wrote directly into the output buffer
+size_t scalarEncode(const unsigned char* input, size_t size, char* output) {
+    char* const begin = output;
+
+    for (; size >= 3; size -= 3, input += 3) {
+        *output++ = base64_chars[(input[0] & 0xfc) >> 2];
+        *output++ = base64_chars[((input[0] & 0x03) << 4) + ((input[1] & 0xf0) >> 4)];
+        *output++ = base64_chars[((input[1] & 0x0f) << 2) + ((input[2] & 0xc0) >> 6)];
+        *output++ = base64_chars[input[2] & 0x3f];
+    }
+
+    if (size > 0) {
+        const unsigned char second = size > 1 ? input[1] : 0;
+
+        *output++ = base64_chars[(input[0] & 0xfc) >> 2];
+        *output++ = base64_chars[((input[0] & 0x03) << 4) + ((second & 0xf0) >> 4)];
+        *output++ = size > 1 ? base64_chars[(second & 0x0f) << 2] : '=';
+        *output++ = '=';
+    }
+
+    return static_cast<size_t>(output - begin);
+}
+
+/**
+ * @brief Runs function until at least minimumDuration passed and returns the throughput in MB/s of input.
+ */
+template <typename Function>
+double measure(size_t inputSize, Function&& function) {
+    const auto minimumDuration = chrono::milliseconds(200);
+    const auto start           = chrono::steady_clock::now();
+    size_t     iterations      = 0;
+    auto       elapsed         = chrono::steady_clock::duration::zero();
+
+    do {
+        function();
+        iterations++;
+        elapsed = chrono::steady_clock::now() - start;
+    } while (elapsed < minimumDuration);
+
+    const double seconds = chrono::duration<double>(elapsed).count();
+    return static_cast<double>(inputSize * iterations) / seconds / (1024.0 * 1024.0);
+}
+} // namespace
+
+int main() {
+    const size_t sizes[] = {1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+
+    mt19937 random(42);
+
+    cout << setw(12) << "bytes" << setw(14) << "legacy MB/s" << setw(14) << "scalar MB/s" << setw(14) << "docmala MB/s" << "\n";
+
+    for (const auto size : sizes) {
+        string input(size, '\0');
+        generate(input.begin(), input.end(), [&random]() { return static_cast<char>(random() & 0xff); });
+
+        const auto   data = reinterpret_cast<const unsigned char*>(input.data());
+        vector<char> output(docmala::base64::encodedSize(size));
+
+        const string expected = legacyEncode(input);
+        if (docmala::base64::encode(data, size, output.data()) != expected.size() || !equal(expected.begin(), expected.end(), output.begin())) {
+            cout << "Encoded output differs for " << size << " bytes\n";
+            return EXIT_FAILURE;
+        }
+
+        size_t     sink   = 0;
+        const auto legacy = measure(size, [&]() { sink += legacyEncode(input).size(); });
+        const auto scalar = measure(size, [&]() { sink += scalarEncode(data, size, output.data()); });
+        const auto current = measure(size, [&]() { sink += docmala::base64::encode(data, size, output.data()); });
+
+        cout << setw(12) << size << fixed << setprecision(1) << setw(14) << legacy << setw(14) << scalar << setw(14) << current << "\n";
+
+        if (sink == 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
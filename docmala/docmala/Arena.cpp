@@ -0,0 +1,68 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace docmala;
+
+namespace {
+Arena*& currentArena() {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+}
+} // namespace
+
+Arena::Arena(std::size_t blockSize)
+    : _blockSize(blockSize) {}
+
+Arena::~Arena() = default;
+
+void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    auto padding = (alignment - reinterpret_cast<std::uintptr_t>(_position) % alignment) % alignment;
+    if (_position == nullptr || padding + size > _remaining) {
+        // blocks grow with the document, large allocations get a block of their own size
+        const auto blockSize = std::max(_blockSize, size + alignment);
+        _blocks.emplace_back(new char[blockSize]);
+        _position  = _blocks.back().get();
+        _remaining = blockSize;
+        _blockSize = std::min<std::size_t>(_blockSize * 2, 16 * 1024 * 1024);
+        padding    = (alignment - reinterpret_cast<std::uintptr_t>(_position) % alignment) % alignment;
+    }
+    void* result = _position + padding;
+    _position += padding + size;
+    _remaining -= padding + size;
+    return result;
+}
+
+Arena* Arena::current() {
+    return currentArena();
+}
+
+Arena::Scope::Scope(Arena* arena)
+    : _previous(currentArena()) {
+    currentArena() = arena;
+}
+
+Arena::Scope::~Scope() {
+    currentArena() = _previous;
+}
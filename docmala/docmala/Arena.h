@@ -0,0 +1,149 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace docmala {
+
+/**
+ * @brief A monotonic memory resource. Memory is handed out from a few large blocks and is only
+ *        released as a whole, when the arena is destroyed.
+ *
+ * The arena a document tree is allocated from is selected per thread with Arena::Scope.
+ * An arena is not thread safe, it is filled by the thread that parses into it.
+ * Arenas are owned by a Document, the allocators only refer to them.
+ */
+class DOCMALA_API Arena {
+public:
+    explicit Arena(std::size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    /**
+     * @brief Returns the arena new document parts of this thread are allocated from, nullptr if the heap is used.
+     */
+    static Arena* current();
+
+    /**
+     * @brief Makes an arena the current arena of this thread, until the scope is left.
+     */
+    class DOCMALA_API Scope {
+    public:
+        explicit Scope(Arena* arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Arena* _previous;
+    };
+
+private:
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    std::size_t                          _blockSize;
+    char*                                _position  = nullptr;
+    std::size_t                          _remaining = 0;
+};
+
+/**
+ * @brief Allocator for document parts. A default constructed allocator uses the current arena of the
+ *        thread (or the heap), a copied container is allocated in the arena that is current at the time of the copy.
+ *        The allocator does not own its arena, parts allocated from an arena must not outlive the document owning it.
+ *        Data, that is kept longer (e.g. caches of plugins), has to be copied to plain heap types.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type                             = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    ArenaAllocator() noexcept
+        : _arena(Arena::current()) {}
+
+    explicit ArenaAllocator(Arena* arena) noexcept
+        : _arena(arena) {}
+
+    ArenaAllocator(const ArenaAllocator& other) noexcept = default;
+
+    // a moved from allocator has to compare equal to the new one, so it keeps its arena
+    ArenaAllocator(ArenaAllocator&& other) noexcept
+        : _arena(other._arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : _arena(other.arena()) {}
+
+    ArenaAllocator& operator=(const ArenaAllocator& other) noexcept = default;
+
+    ArenaAllocator& operator=(ArenaAllocator&& other) noexcept {
+        _arena = other._arena;
+        return *this;
+    }
+
+    T* allocate(std::size_t count) {
+        if (_arena) {
+            return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, std::size_t count) {
+        // memory of an arena is released as a whole
+        if (!_arena) {
+            std::allocator<T>().deallocate(pointer, count);
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    }
+
+    Arena* arena() const {
+        return _arena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return _arena == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return _arena != other.arena();
+    }
+
+private:
+    Arena* _arena;
+};
+}
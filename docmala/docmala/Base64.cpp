@@ -0,0 +1,168 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Base64.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+#ifdef DOCMALA_CPU_X86
+#include <immintrin.h>
+#endif
+
+using namespace docmala;
+
+namespace {
+using EncodeFunction = std::size_t (*)(const unsigned char*, std::size_t, char*);
+
+const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                        "abcdefghijklmnopqrstuvwxyz"
+                        "0123456789+/";
+
+/**
+ * @brief Maps 12 bits of input to the two characters encoding them, so 3 bytes take two lookups.
+ */
+struct PairTable {
+    PairTable() {
+        for (unsigned int i = 0; i < 4096; i++) {
+            pairs[i][0] = alphabet[i >> 6];
+            pairs[i][1] = alphabet[i & 0x3f];
+        }
+    }
+
+    char pairs[4096][2];
+};
+
+std::size_t encodeScalar(const unsigned char* input, std::size_t size, char* output) {
+    static const PairTable table;
+    char* const            begin = output;
+
+    for (; size >= 3; size -= 3, input += 3, output += 4) {
+        const unsigned int value = (static_cast<unsigned int>(input[0]) << 16) | (static_cast<unsigned int>(input[1]) << 8) | input[2];
+        std::memcpy(output, table.pairs[value >> 12], 2);
+        std::memcpy(output + 2, table.pairs[value & 0xfff], 2);
+    }
+
+    if (size > 0) {
+        const unsigned int second = size > 1 ? input[1] : 0;
+
+        *output++ = alphabet[input[0] >> 2];
+        *output++ = alphabet[((input[0] & 0x03) << 4) | (second >> 4)];
+        *output++ = size > 1 ? alphabet[(second & 0x0f) << 2] : '=';
+        *output++ = '=';
+    }
+
+    return static_cast<std::size_t>(output - begin);
+}
+
+#ifdef DOCMALA_CPU_X86
+// The vectorized variants follow W. Mula's and D. Lemire's "Faster Base64 Encoding and Decoding using AVX2 Instructions":
+// 12 input bytes per 128 bit lane are spread to 16 six bit indices, which are then translated to ASCII
+// by adding a per range offset, selected with a byte shuffle.
+
+#if !defined(_MSC_VER)
+__attribute__((target("ssse3")))
+#endif
+__m128i
+encodeBlockSsse3(__m128i input) {
+    // duplicate the three bytes of every group, so each 32 bit word holds one group in the order [b1 b0 b2 b1]
+    input = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // move the four six bit fields of every word into its four bytes
+    const __m128i first  = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    const __m128i second = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(first, second);
+
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i ranges = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    ranges         = _mm_or_si128(ranges, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+
+    const __m128i offsets
+        = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, ranges));
+}
+
+#if !defined(_MSC_VER)
+__attribute__((target("ssse3")))
+#endif
+std::size_t
+encodeSsse3(const unsigned char* input, std::size_t size, char* output) {
+    char* const begin = output;
+
+    // 16 bytes are loaded to encode 12, the rest is left to the scalar implementation
+    for (; size >= 16; size -= 12, input += 12, output += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), encodeBlockSsse3(block));
+    }
+
+    return static_cast<std::size_t>(output - begin) + encodeScalar(input, size, output);
+}
+
+#if !defined(_MSC_VER)
+__attribute__((target("avx2")))
+#endif
+std::size_t
+encodeAvx2(const unsigned char* input, std::size_t size, char* output) {
+    char* const begin = output;
+
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    // each lane encodes 12 bytes, the upper lane is loaded from input + 12, so 28 bytes have to be readable
+    for (; size >= 28; size -= 24, input += 24, output += 32) {
+        const __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 12));
+        __m256i       block = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+
+        block = _mm256_shuffle_epi8(block, shuffle);
+
+        const __m256i first   = _mm256_mulhi_epu16(_mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        const __m256i second  = _mm256_mullo_epi16(_mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(first, second);
+
+        __m256i ranges = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        ranges         = _mm256_or_si256(ranges, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, ranges)));
+    }
+
+    return static_cast<std::size_t>(output - begin) + encodeSsse3(input, size, output);
+}
+#endif
+
+EncodeFunction selectEncode() {
+#ifdef DOCMALA_CPU_X86
+    if (cpu::supportsAvx2()) {
+        return encodeAvx2;
+    }
+    if (cpu::supportsSsse3()) {
+        return encodeSsse3;
+    }
+#endif
+    return encodeScalar;
+}
+} // namespace
+
+std::size_t base64::encode(const unsigned char* input, std::size_t size, char* output) {
+    static const EncodeFunction implementation = selectEncode();
+    return implementation(input, size, output);
+}
@@ -0,0 +1,43 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <cstddef>
+
+namespace docmala {
+namespace base64 {
+
+/**
+ * @brief Number of characters, including padding, that encode() writes for size bytes.
+ */
+constexpr std::size_t encodedSize(std::size_t size) {
+    return 4 * ((size + 2) / 3);
+}
+
+/**
+ * @brief Encodes size bytes to encodedSize(size) characters in output, returns the number of characters written.
+ *        A vectorized implementation (AVX2, SSSE3 or a table driven scalar one) is selected at runtime.
+ */
+DOCMALA_API std::size_t encode(const unsigned char* input, std::size_t size, char* output);
+
+} // namespace base64
+} // namespace docmala
@@ -0,0 +1,158 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "BuildCache.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+using namespace docmala;
+
+namespace {
+const char* const recordHeader = "docmala-build-cache 1";
+const char* const missingFile  = "missing";
+
+std::string dependencyHash(const std::string& fileName) {
+    std::uint64_t result = 0;
+    if (!hash::computeForFile(fileName, result)) {
+        return missingFile;
+    }
+    return hash::toHex(result);
+}
+
+void createDirectory(const std::string& directory) {
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+} // namespace
+
+BuildCache::BuildCache(const std::string& directory)
+    : _directory(directory) {
+    createDirectory(_directory);
+}
+
+std::string BuildCache::recordFileName(const std::string& inputFile) const {
+    return _directory + "/" + hash::toHex(hash::compute(inputFile)) + ".dep";
+}
+
+bool BuildCache::isUpToDate(const std::string& inputFile, const std::string& configuration, std::set<std::string>* dependencies) const {
+    std::ifstream record(recordFileName(inputFile));
+    if (!record) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(record, line) || line != recordHeader) {
+        return false;
+    }
+
+    bool inputMatches         = false;
+    bool configurationMatches = false;
+
+    // every line is "<kind> <value>", where value may contain spaces
+    while (std::getline(record, line)) {
+        const auto separator = line.find(' ');
+        if (separator == std::string::npos) {
+            return false;
+        }
+        const auto kind  = line.substr(0, separator);
+        const auto value = line.substr(separator + 1);
+
+        if (kind == "input") {
+            if (value != inputFile) {
+                return false;
+            }
+            inputMatches = true;
+        } else if (kind == "configuration") {
+            if (value != hash::toHex(hash::compute(configuration))) {
+                return false;
+            }
+            configurationMatches = true;
+        } else if (kind == "dependency") {
+            const auto hashEnd = value.find(' ');
+            const auto fileName = value.substr(hashEnd + 1);
+            if (hashEnd == std::string::npos || value.substr(0, hashEnd) != dependencyHash(fileName)) {
+                return false;
+            }
+            if (dependencies != nullptr) {
+                dependencies->insert(fileName);
+            }
+        } else if (kind == "output") {
+            if (!std::ifstream(value)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return inputMatches && configurationMatches;
+}
+
+bool BuildCache::store(const std::string&                          inputFile,
+                       const std::string&                          configuration,
+                       const std::set<std::string>&                dependencies,
+                       const std::map<std::string, std::uint64_t>& dependencyHashes,
+                       const std::vector<std::string>&             outputFiles) const {
+    std::ostringstream record;
+    record << recordHeader << "\n";
+    record << "input " << inputFile << "\n";
+    record << "configuration " << hash::toHex(hash::compute(configuration)) << "\n";
+    for (const auto& dependency : dependencies) {
+        const auto contentHash = dependencyHashes.find(dependency);
+        record << "dependency " << (contentHash != dependencyHashes.end() ? hash::toHex(contentHash->second) : missingFile) << " " << dependency << "\n";
+    }
+    for (const auto& output : outputFiles) {
+        record << "output " << output << "\n";
+    }
+
+    // write to a temporary file first, an interrupted build must not leave a truncated record behind
+    const auto fileName          = recordFileName(inputFile);
+    const auto temporaryFileName = fileName + ".tmp";
+    {
+        std::ofstream writer(temporaryFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!writer) {
+            return false;
+        }
+        writer << record.str();
+        if (!writer.flush()) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    std::remove(fileName.c_str());
+#endif
+    return std::rename(temporaryFileName.c_str(), fileName.c_str()) == 0;
+}
+
+void BuildCache::invalidate(const std::string& inputFile) const {
+    std::remove(recordFileName(inputFile).c_str());
+}
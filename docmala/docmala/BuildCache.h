@@ -0,0 +1,73 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace docmala {
+
+/**
+ * @brief Persistent record of what each output was built from, to skip documents whose inputs did not change.
+ *
+ * For every input file a record is kept in the cache directory. It holds the content hashes of all files the
+ * document depends on (the input itself, included files, images, ...), the hash of the build configuration
+ * (parameters, output plugins and plugin versions) and the files that were written.
+ * Records of different input files are independent, so documents may be checked and stored in parallel.
+ */
+class DOCMALA_API BuildCache {
+public:
+    explicit BuildCache(const std::string& directory);
+
+    /**
+     * @brief Returns true, if a record for inputFile exists, that was built with the same configuration,
+     *        all recorded dependencies still have the same content and all outputs still exist.
+     *        The recorded dependencies are added to dependencies, if given.
+     */
+    bool isUpToDate(const std::string& inputFile, const std::string& configuration, std::set<std::string>* dependencies = nullptr) const;
+
+    /**
+     * @brief Records a successful build of inputFile. The content hashes of the dependencies are the ones
+     *        taken when they were read (see Document::dependencyHashes), a dependency without one is recorded
+     *        as missing, so a file changed during the build is not mistaken as built.
+     * @return false, if the record could not be written
+     */
+    bool store(const std::string&                          inputFile,
+               const std::string&                          configuration,
+               const std::set<std::string>&                dependencies,
+               const std::map<std::string, std::uint64_t>& dependencyHashes,
+               const std::vector<std::string>&             outputFiles) const;
+
+    /**
+     * @brief Removes the record of inputFile, e.g. after a failed build.
+     */
+    void invalidate(const std::string& inputFile) const;
+
+private:
+    std::string recordFileName(const std::string& inputFile) const;
+
+    std::string _directory;
+};
+} // namespace docmala
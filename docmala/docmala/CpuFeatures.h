@@ -0,0 +1,38 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DOCMALA_CPU_X86
+#endif
+
+namespace docmala {
+namespace cpu {
+
+/**
+ * @brief Runtime detection of instruction set extensions, used to select vectorized code paths.
+ *        Both return false on platforms other than x86-64.
+ */
+bool supportsSsse3();
+bool supportsAvx2();
+
+} // namespace cpu
+} // namespace docmala
@@ -39,6 +39,11 @@ public:
         DocumentChanged ///< Preprocessing is done when the document changed
     };
 
+    enum class Execution {
+        Immediate, ///< process is called while parsing, at the position of the plugin tag
+        Deferred ///< process is called on a worker thread, while parsing continues
+    };
+
     virtual ~DocumentPlugin();
 
     /**
@@ -49,6 +54,18 @@ public:
         return BlockProcessing::No;
     }
 
+    /**
+     * @brief Defines when process is called.
+     *
+     * A deferred plugin gets an empty document of its own, its parts are moved to the position of the plugin tag
+     * before post processing. process may run for several plugin tags at the same time, so it has to be
+     * reentrant, and it can not look at the parts in front of the plugin tag.
+     * @return Requested execution mode.
+     */
+    virtual Execution execution() const {
+        return Execution::Immediate;
+    }
+
     /**
      * @brief Execute plugin
      * @param parameters Parameters for plugin execution
@@ -87,6 +104,14 @@ class OutputPlugin {
 public:
     virtual ~OutputPlugin() {}
     virtual bool write(const ParameterList& parameters, const Document& document) = 0;
+
+    /**
+     * @brief Returns the files written by the last call of write.
+     *        Used to detect deleted outputs of otherwise unchanged documents.
+     */
+    virtual std::vector<std::string> outputFiles() const {
+        return {};
+    }
 };
 }
 
@@ -21,18 +21,93 @@
 #include "Docmala.h"
 #include "DocmaPlugin.h"
 #include "File.h"
+#include "Hash.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <extension_system/ExtensionSystem.hpp>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
 
 using namespace docmala;
 
-Docmala::Docmala(const std::string& pluginDir)
-    : _pluginLoader(new extension_system::ExtensionSystem())
-    , _pluginDir(pluginDir) {
-    _pluginLoader->searchDirectory(pluginDir, false);
+namespace {
+ThreadPool& deferredProcessingPool() {
+    static ThreadPool pool;
+    return pool;
 }
 
+/**
+ * @brief Plugin discovery opens every shared library in the plugin directory, so all parsers using the same
+ *        directory share one extension system, e.g. the parsers of a batch build and those of included files.
+ *        It lives as long as a parser uses it.
+ */
+std::shared_ptr<extension_system::ExtensionSystem> sharedPluginLoader(std::string pluginDir) {
+    static std::mutex                                                              mutex;
+    static std::map<std::string, std::weak_ptr<extension_system::ExtensionSystem>> loaders;
+
+    // "plugins", "plugins/" and "plugins//" are the same directory
+    while (pluginDir.size() > 1 && (pluginDir.back() == '/' || pluginDir.back() == '\\')) {
+        pluginDir.pop_back();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto&                       loader = loaders[pluginDir];
+    auto                        result = loader.lock();
+    if (!result) {
+        result = std::make_shared<extension_system::ExtensionSystem>();
+        result->searchDirectory(pluginDir, false);
+        loader = result;
+    }
+    return result;
+}
+} // namespace
+
+/**
+ * @brief Execution of a deferred plugin. It is run by a worker or by the parser waiting for it, whoever comes
+ *        first, so waiting never depends on a free worker (e.g. for plugins, that parse other files).
+ */
+struct Docmala::DeferredProcessing {
+    std::function<std::vector<Error>(Document&)> work;
+    size_t                                       part          = 0;
+    size_t                                       errorPosition = 0;
+    FileLocation                                 location;
+    bool                                         useArena      = false;
+
+    std::atomic<bool>         claimed{false};
+    std::promise<void>        finished;
+    std::future<void>         result = finished.get_future();
+    std::unique_ptr<Document> document;
+    std::vector<Error>        errors;
+
+    void run() {
+        if (claimed.exchange(true)) {
+            return;
+        }
+        try {
+            // the parts go to an own arena, that is taken over by the parser's document when they are merged
+            document = std::make_unique<Document>();
+            document->useArena(useArena);
+            Arena::Scope arenaScope(document->arena());
+            errors = work(*document);
+            // the plugin is released here, not by a worker after the parser (and its plugin loader) is gone
+            work = nullptr;
+            finished.set_value();
+        } catch (...) {
+            work = nullptr;
+            finished.set_exception(std::current_exception());
+        }
+    }
+};
+
+Docmala::Docmala(const std::string& pluginDir)
+    : _pluginLoader(sharedPluginLoader(pluginDir))
+    , _pluginDir(pluginDir) {}
+
 Docmala::Docmala(const Document& other, const std::string& pluginDir)
     : Docmala(pluginDir) {
     _document.inheritFrom(other);
@@ -46,11 +121,27 @@ void Docmala::setParameters(const ParameterList& parameters) {
 
 bool Docmala::parseFile(const std::string& fileName) {
     _file = std::make_unique<File>(fileName);
-    return parse();
+
+    // the content is hashed as it is parsed, not when the build is recorded (an empty file is not mapped)
+    std::uint64_t contentHash = 0;
+    bool          read        = true;
+    if (_file->isOpen()) {
+        contentHash = hash::compute(_file->data());
+    } else {
+        read = hash::computeForFile(fileName, contentHash);
+    }
+
+    auto result = parse();
+    if (read) {
+        _document.addDependency(fileName, contentHash);
+    } else {
+        _document.addDependency(fileName);
+    }
+    return result;
 }
 
-bool Docmala::parseData(const std::string& data, const std::string& fileName) {
-    _file = std::make_unique<MemoryFile>(data, fileName);
+bool Docmala::parseData(boost::string_view data, const std::string& fileName) {
+    _file = std::make_unique<MemoryFileView>(data, fileName);
     return parse();
 }
 
@@ -58,12 +149,11 @@ bool Docmala::produceOutput(const std::string& pluginName) {
     auto plugin = _pluginLoader->createExtension<OutputPlugin>(pluginName);
 
     if (plugin) {
-        produceOutput(plugin);
-    } else {
-        _errors.emplace_back(FileLocation(), "Unable to load output plugin '" + pluginName + "'.");
-        return false;
+        return produceOutput(plugin);
     }
-    return true;
+
+    _errors.emplace_back(FileLocation(), "Unable to load output plugin '" + pluginName + "'.");
+    return false;
 }
 
 bool Docmala::produceOutput(const std::shared_ptr<OutputPlugin>& plugin) {
@@ -71,8 +161,11 @@ bool Docmala::produceOutput(const std::shared_ptr<OutputPlugin>& plugin) {
         ParameterList parameters = _parameters;
 
         parameters.insert(std::make_pair("inputFile", Parameter{"inputFile", _file->fileName(), FileLocation()}));
-        plugin->write(parameters, _document);
-        return true;
+        const bool written = plugin->write(parameters, _document);
+
+        auto files = plugin->outputFiles();
+        _outputFiles.insert(_outputFiles.end(), files.begin(), files.end());
+        return written;
     }
     return false;
 }
@@ -89,19 +182,40 @@ std::vector<std::string> Docmala::listOutputPlugins() const {
     return knownOutputPlugins;
 }
 
-void Docmala::readComment() {
-    while (!_file->isEoF()) {
-        char c = _file->getch();
-        if (c == '\n') {
-            break;
+std::map<std::string, unsigned int> Docmala::pluginVersions() const {
+    std::map<std::string, unsigned int> versions;
+
+    auto addVersions = [&versions](const std::string& prefix, const std::vector<extension_system::ExtensionDescription>& plugins) {
+        for (const auto& plugin : plugins) {
+            auto& version = versions[prefix + plugin.name()];
+            version       = std::max(version, plugin.version());
         }
+    };
+
+    addVersions("document/", _pluginLoader->extensions<DocumentPlugin>());
+    addVersions("output/", _pluginLoader->extensions<OutputPlugin>());
+    return versions;
+}
+
+void Docmala::readComment() {
+    if (_file->skipUntil('\n')) {
+        _file->getch();
     }
 }
 
+void Docmala::useArena(bool enable) {
+    _document.useArena(enable);
+}
+
 bool Docmala::parse() {
     _document.clear();
     _errors.clear();
     _registeredPostprocessing.clear();
+    _deferredProcessing.clear();
+    _outputFiles.clear();
+
+    // everything created while parsing goes to the arena of the document, if there is one
+    Arena::Scope arenaScope(_document.arena());
 
     if (!_file->isOpen()) {
         _errors.emplace_back(FileLocation(), "Unable to open file '" + _file->fileName() + "'.");
@@ -136,46 +250,108 @@ bool Docmala::parse() {
                     readMetaData();
                     break;
                 case '[':
-                    if (_file->following() == '[') {
+                    if (_file->peek() == '[') {
                         document_part::Text text;
                         readText(c, text);
-                        _document.addPart(text);
+                        _document.addPart(std::move(text));
                     } else {
                         readPlugin();
                     }
                     break;
                 case '#':
-                    if (isWhitespace(_file->following()) || _file->following() == '#') {
+                    if (isWhitespace(_file->peek()) || _file->peek() == '#') {
                         readList(document_part::List::Type::Numbered);
                     } else {
                         document_part::Text text;
                         readText(c, text);
-                        _document.addPart(text);
+                        _document.addPart(std::move(text));
                     }
                     break;
                 case '*':
-                    if (isWhitespace(_file->following()) || _file->following() == '*') {
+                    if (isWhitespace(_file->peek()) || _file->peek() == '*') {
                         readList(document_part::List::Type::Points);
                     } else {
                         document_part::Text text;
                         readText(c, text);
-                        _document.addPart(text);
+                        _document.addPart(std::move(text));
                     }
                     break;
                 case '<':
                 default: {
                     document_part::Text text;
                     readText(c, text);
-                    _document.addPart(text);
+                    _document.addPart(std::move(text));
                 }
             }
         }
     }
+    collectDeferredProcessing();
     doPostprocessing();
     checkConsistency();
     return true;
 }
 
+void Docmala::deferProcessing(const std::shared_ptr<DocumentPlugin>& plugin,
+                              const ParameterList&                   parameters,
+                              const FileLocation&                    location,
+                              const std::string&                     block) {
+    auto deferred           = std::make_shared<DeferredProcessing>();
+    deferred->work          = [plugin, parameters, location, block](Document& document) { return plugin->process(parameters, location, document, block); };
+    deferred->part          = _document.parts().size();
+    deferred->errorPosition = _errors.size();
+    deferred->location      = location;
+    deferred->useArena      = _document.arena() != nullptr;
+
+    // the placeholder keeps the parser's view of the last part, e.g. a following list does not continue the one in front of the plugin
+    _document.addPart(document_part::GeneratedDocument(location));
+    _deferredProcessing.push_back(deferred);
+    deferredProcessingPool().submit([deferred]() { deferred->run(); });
+}
+
+void Docmala::collectDeferredProcessing() {
+    if (_deferredProcessing.empty()) {
+        return;
+    }
+
+    for (const auto& deferred : _deferredProcessing) {
+        deferred->run();
+        deferred->result.get();
+    }
+
+    // replace the placeholders by the parts of the plugins in one pass
+    auto&                   parts = _document.parts();
+    document_part::PartList merged(parts.get_allocator());
+    merged.reserve(parts.size());
+
+    auto deferred = _deferredProcessing.begin();
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (deferred != _deferredProcessing.end() && (*deferred)->part == i) {
+            auto& document = *(*deferred)->document;
+            std::move(document.parts().begin(), document.parts().end(), std::back_inserter(merged));
+            _document.mergeFrom(document);
+            ++deferred;
+        } else {
+            merged.push_back(std::move(parts[i]));
+        }
+    }
+    parts.swap(merged);
+
+    // errors are inserted where they would have been reported by an immediate plugin, back to front to keep the positions valid
+    for (auto iter = _deferredProcessing.rbegin(); iter != _deferredProcessing.rend(); ++iter) {
+        auto& errors = (*iter)->errors;
+        if (errors.empty()) {
+            continue;
+        }
+        for (auto& error : errors) {
+            error.message = "    " + error.message;
+        }
+        errors.insert(errors.begin(), Error((*iter)->location, "Errors occured during plugin execution"));
+        _errors.insert(_errors.begin() + static_cast<std::ptrdiff_t>((*iter)->errorPosition), errors.begin(), errors.end());
+    }
+
+    _deferredProcessing.clear();
+}
+
 void Docmala::doPostprocessing() {
     bool documentChanged = true;
     while (documentChanged) {
@@ -199,7 +375,7 @@ void Docmala::doPostprocessing() {
     postProcessPartList(_document.parts());
 }
 
-void Docmala::postProcessPartList(const std::vector<document_part::Variant>& parts) {
+void Docmala::postProcessPartList(const document_part::PartList& parts) {
     auto visitor = make_visitor(
         // visitors
         [this](document_part::Anchor& anchor) {
@@ -207,7 +383,7 @@ void Docmala::postProcessPartList(const std::vector<document_part::Variant>& par
             if (prevAnchor != _document.anchors().end() && prevAnchor->second.location != anchor.location) {
                 auto      loc = prevAnchor->second.location;
                 ErrorData additionalInfo{loc,
-                                         std::string("Previous definition of '") + anchor.name + "' is at " + loc.fileName + "("
+                                         std::string("Previous definition of '") + anchor.name + "' is at " + loc.fileName() + "("
                                              + std::to_string(loc.line) + ":" + std::to_string(loc.column) + ")"};
                 _errors.push_back(
                     Error{anchor.location, std::string("Anchor with name '") + anchor.name + "' already defined.", {additionalInfo}});
@@ -216,8 +392,8 @@ void Docmala::postProcessPartList(const std::vector<document_part::Variant>& par
         },
         [this](const document_part::Text& text) { postProcessPartList(text.text); },
         [this](const document_part::Table& table) {
-            for (auto row : table.cells) {
-                for (auto cell : row) {
+            for (const auto& row : table.cells) {
+                for (const auto& cell : row) {
                     postProcessPartList(cell.content);
                 }
             }
@@ -258,7 +434,7 @@ bool Docmala::readHeadLine() {
         } else {
             document_part::Text text;
             readText(c, text);
-            _document.addPart(document_part::Headline(text, level));
+            _document.emplacePart<document_part::Headline>(std::move(text), level);
             return true;
         }
     }
@@ -272,17 +448,14 @@ bool Docmala::readCaption() {
     if (!readText('\0', text)) {
         return false;
     }
-    _document.addPart(document_part::Caption(text));
+    _document.emplacePart<document_part::Caption>(std::move(text));
     return true;
 }
 
 bool Docmala::readLine(std::string& destination) {
-    while (!_file->isEoF()) {
-        char c = _file->getch();
-        if (c == '\n') {
-            break;
-        }
-        destination.push_back(c);
+    _file->takeUntil("\n", destination);
+    if (!_file->isEoF()) {
+        _file->getch();
     }
     return true;
 }
@@ -340,6 +513,9 @@ bool Docmala::readPlugin() {
         }
     }
 
+    // global parameters (e.g. cache locations) are visible to document plugins, parameters of the block take precedence
+    parameters.insert(_parameters.begin(), _parameters.end());
+
     std::shared_ptr<DocumentPlugin> plugin;
     if (_loadedDocumentPlugins.find(name) != _loadedDocumentPlugins.end()) {
         plugin = _loadedDocumentPlugins[name];
@@ -359,51 +535,47 @@ bool Docmala::readPlugin() {
         _registeredPostprocessing.push_back(postProcessing);
     }
 
+    std::string block;
     if (plugin->blockProcessing() == DocumentPlugin::BlockProcessing::Required
         || plugin->blockProcessing() == DocumentPlugin::BlockProcessing::Optional) {
-        std::string block;
         if (!readBlock(block)) {
             return false;
         }
-        auto errors = plugin->process(parameters, nameBegin, _document, block);
-        if (!errors.empty()) {
-            for (auto& error : errors) {
-                error.message = "    " + error.message;
-            }
-            _errors.emplace_back(nameBegin, "Errors occured during plugin execution");
-            _errors.insert(_errors.end(), errors.begin(), errors.end());
-        }
+    }
 
-    } else {
-        auto errors = plugin->process(parameters, nameBegin, _document, "");
-        if (!errors.empty()) {
-            for (auto& error : errors) {
-                error.message = "    " + error.message;
-            }
-            _errors.emplace_back(nameBegin, "Errors occured during plugin execution");
-            _errors.insert(_errors.end(), errors.begin(), errors.end());
+    if (plugin->execution() == DocumentPlugin::Execution::Deferred) {
+        deferProcessing(plugin, parameters, nameBegin, block);
+        return true;
+    }
+
+    auto errors = plugin->process(parameters, nameBegin, _document, block);
+    if (!errors.empty()) {
+        for (auto& error : errors) {
+            error.message = "    " + error.message;
         }
+        _errors.emplace_back(nameBegin, "Errors occured during plugin execution");
+        _errors.insert(_errors.end(), errors.begin(), errors.end());
     }
 
     return true;
 }
 
-bool Docmala::readAnchor(IFile* file, std::vector<Error>& errors, document_part::Text& outText) {
+bool Docmala::readAnchor(MemoryFile* file, std::vector<Error>& errors, document_part::Text& outText) {
     enum class Mode { Begin, Name, EndTag1, EndTag2 } mode{Mode::Begin};
 
-    std::string name;
-    auto        anchorLocation = file->location();
+    document_part::String name;
+    auto                  anchorLocation = file->location();
 
     while (!file->isEoF()) {
-        auto location = file->location();
-        char c        = file->getch();
+        auto offset = file->offset();
+        char c      = file->getch();
 
         if (mode == Mode::Begin) {
             if (c == '[') {
                 mode = Mode::Name;
                 continue;
             }
-            errors.emplace_back(location, std::string("Expected '[' but got '") + c + "'. This is an error in Docmala.");
+            errors.emplace_back(file->location(offset), std::string("Expected '[' but got '") + c + "'. This is an error in Docmala.");
             return false;
         }
         if (mode == Mode::Name) {
@@ -429,10 +601,10 @@ bool Docmala::readAnchor(IFile* file, std::vector<Error>& errors, document_part:
             }
         } else if (mode == Mode::EndTag1) {
             if (c != ']') {
-                errors.emplace_back(location, std::string("Error while parsing anchor. Expected ']' but got '") + c + "'.");
+                errors.emplace_back(file->location(offset), std::string("Error while parsing anchor. Expected ']' but got '") + c + "'.");
                 return false;
             }
-            outText.text.emplace_back(document_part::Anchor{name, anchorLocation});
+            outText.text.emplace_back(document_part::Anchor{std::move(name), anchorLocation});
             return true;
 
         } else if (mode == Mode::EndTag2) {
@@ -443,7 +615,7 @@ bool Docmala::readAnchor(IFile* file, std::vector<Error>& errors, document_part:
                 mode = Mode::EndTag1;
                 continue;
             }
-            errors.emplace_back(location, std::string("Error while parsing anchor. Expected ']' but got '") + c + "'.");
+            errors.emplace_back(file->location(offset), std::string("Error while parsing anchor. Expected ']' but got '") + c + "'.");
             return false;
         }
     }
@@ -456,23 +628,23 @@ bool Docmala::readLink(document_part::Text& outText) {
     return readLink(_file.get(), _errors, outText);
 }
 
-bool Docmala::readLink(IFile* file, std::vector<Error>& errors, document_part::Text& outText) {
+bool Docmala::readLink(MemoryFile* file, std::vector<Error>& errors, document_part::Text& outText) {
     enum class Mode { Begin, Data, Text, EndTag1, EndTag2 } mode{Mode::Begin};
 
-    std::string text;
-    std::string data;
-    auto        linkLocation = file->location();
+    document_part::String text;
+    document_part::String data;
+    auto                  linkLocation = file->location();
 
     while (!file->isEoF()) {
-        auto location = file->location();
-        char c        = file->getch();
+        auto offset = file->offset();
+        char c      = file->getch();
 
         if (mode == Mode::Begin) {
             if (c == '<') {
                 mode = Mode::Data;
                 continue;
             }
-            errors.emplace_back(location, std::string("Expected '<' but got '") + c + "'. This is an error in Docmala.");
+            errors.emplace_back(file->location(offset), std::string("Expected '<' but got '") + c + "'. This is an error in Docmala.");
             return false;
         }
         if (mode == Mode::Data) {
@@ -513,7 +685,7 @@ bool Docmala::readLink(IFile* file, std::vector<Error>& errors, document_part::T
 
         } else if (mode == Mode::EndTag1) {
             if (c != '>') {
-                errors.emplace_back(location, std::string("Error while parsing link. Expected '>' but got '") + c + "'.");
+                errors.emplace_back(file->location(offset), std::string("Error while parsing link. Expected '>' but got '") + c + "'.");
                 return false;
             }
             auto type = document_part::Link::Type::IntraFile;
@@ -529,7 +701,7 @@ bool Docmala::readLink(IFile* file, std::vector<Error>& errors, document_part::T
                 return false;
             }
 
-            outText.text.emplace_back(document_part::Link{data, text, type, linkLocation});
+            outText.text.emplace_back(document_part::Link{std::move(data), std::move(text), type, linkLocation});
             return true;
 
         } else if (mode == Mode::EndTag2) {
@@ -540,7 +712,7 @@ bool Docmala::readLink(IFile* file, std::vector<Error>& errors, document_part::T
                 mode = Mode::EndTag1;
                 continue;
             }
-            errors.emplace_back(location, std::string("Error while parsing anchor. Expected '>' but got '") + c + "'.");
+            errors.emplace_back(file->location(offset), std::string("Error while parsing anchor. Expected '>' but got '") + c + "'.");
             return false;
         }
     }
@@ -636,7 +808,7 @@ bool Docmala::readMetaData() {
                         ok            = false;
                         auto      loc = current->second.firstLocation;
                         ErrorData ext = {current->second.data.front().location,
-                                         std::string("First definition of '") + metaData.key + "' is at " + loc.fileName + "("
+                                         std::string("First definition of '") + metaData.key + "' is at " + loc.fileName() + "("
                                              + std::to_string(loc.line) + ":" + std::to_string(loc.column) + ")"};
                         _errors.push_back(
                             {_file->location(), std::string("Assignment mode of metadata does not match first definition"), {ext}});
@@ -662,11 +834,34 @@ bool isFormatSpecifier(char c) {
     return c == '_' || c == '*' || c == '-' || c == '/' || c == '\'';
 }
 
+/// characters that end a run of plain text in readText
+const char* const textSpecialCharacters = "_*-/'\n[<\\";
+
 bool Docmala::readText(char startCharacter, document_part::Text& text) {
     return readText(_file.get(), _errors, startCharacter, text);
 }
 
 bool Docmala::readText(IFile* file, std::vector<Error>& errors, char startCharacter, document_part::Text& text) {
+    if (auto memoryFile = dynamic_cast<MemoryFile*>(file)) {
+        return readText(memoryFile, errors, startCharacter, text);
+    }
+
+    // text ends at the end of the line, so reading the line up front consumes the same characters
+    const FileLocation location = file->location();
+    std::string        line;
+    while (startCharacter != '\n' && !file->isEoF()) {
+        const char c = file->getch();
+        line.push_back(c);
+        if (c == '\n') {
+            break;
+        }
+    }
+
+    MemoryFile lineFile(line, location);
+    return readText(&lineFile, errors, startCharacter, text);
+}
+
+bool Docmala::readText(MemoryFile* file, std::vector<Error>& errors, char startCharacter, document_part::Text& text) {
     char                        c = startCharacter;
     document_part::FormatedText formatedText;
 
@@ -677,10 +872,13 @@ bool Docmala::readText(IFile* file, std::vector<Error>& errors, char startCharac
     text.location = file->location();
     while (true) {
         if (isFormatSpecifier(c)) {
-            const char following = file->following();
+            const char following = file->peek();
             if (following == c && file->previous() != '\\') {
-                c          = file->getch();
-                auto store = formatedText;
+                c = file->getch();
+                if (!formatedText.text.empty()) {
+                    text.text.emplace_back(std::move(formatedText));
+                    formatedText.text.clear();
+                }
                 switch (c) {
                     case '_':
                         formatedText.underlined = !formatedText.underlined;
@@ -698,16 +896,12 @@ bool Docmala::readText(IFile* file, std::vector<Error>& errors, char startCharac
                         formatedText.stroked = !formatedText.stroked;
                         break;
                 }
-                if (!store.text.empty()) {
-                    text.text.emplace_back(store);
-                    formatedText.text.clear();
-                }
             } else {
                 formatedText.text.push_back(c);
             }
         } else if (c == '\n') {
             if (!formatedText.text.empty()) {
-                text.text.emplace_back(formatedText);
+                text.text.emplace_back(std::move(formatedText));
             }
             bool ok = true;
             if (formatedText.bold) {
@@ -731,20 +925,20 @@ bool Docmala::readText(IFile* file, std::vector<Error>& errors, char startCharac
                 ok = false;
             }
             return ok;
-        } else if (c == '[' && file->following() == '[' && file->previous() != '\\') {
+        } else if (c == '[' && file->peek() == '[' && file->previous() != '\\') {
             if (!formatedText.text.empty()) {
-                text.text.emplace_back(formatedText);
+                text.text.emplace_back(std::move(formatedText));
             }
             readAnchor(file, errors, text);
             formatedText.text.clear();
-        } else if (c == '<' && file->following() == '<' && file->previous() != '\\') {
+        } else if (c == '<' && file->peek() == '<' && file->previous() != '\\') {
             if (!formatedText.text.empty()) {
-                text.text.emplace_back(formatedText);
+                text.text.emplace_back(std::move(formatedText));
             }
             readLink(file, errors, text);
             formatedText.text.clear();
         } else if (c == '\\') {
-            if (file->following() == '\\') {
+            if (file->peek() == '\\') {
                 c = file->getch();
                 formatedText.text.push_back(c);
             }
@@ -756,12 +950,18 @@ bool Docmala::readText(IFile* file, std::vector<Error>& errors, char startCharac
             break;
         }
 
+        // plain text needs no further inspection and is copied in one go
+        file->takeUntil(textSpecialCharacters, formatedText.text);
+        if (file->isEoF()) {
+            break;
+        }
+
         c = file->getch();
     }
 
     // end of file is no error, when parsing text
     if (!formatedText.text.empty()) {
-        text.text.emplace_back(formatedText);
+        text.text.emplace_back(std::move(formatedText));
     }
     return true;
 }
@@ -939,6 +1139,13 @@ bool Docmala::readBlock(std::string& block) {
     bool        searchingEnd = false;
 
     while (!_file->isEoF()) {
+        if (searchingEnd && potentialDelimiter.empty()) {
+            // block content without potential delimiters is copied in one go
+            _file->takeUntil("-\\", block);
+            if (_file->isEoF()) {
+                break;
+            }
+        }
         char c = _file->getch();
 
         if (c == '-' || (c == '\\' && potentialDelimiter.empty())) {
@@ -990,17 +1197,17 @@ bool Docmala::readList(document_part::List::Type type) {
             readText('\0', text);
 
             if (auto list = _document.last<document_part::List>()) {
-                std::vector<document_part::List::Entry>* entries = &list->entries;
+                document_part::Vector<document_part::List::Entry>* entries = &list->entries;
                 for (int i = 1; i < level; i++) {
                     if (entries->empty()) {
                         entries->push_back({{}, type, {}});
                     }
                     entries = &entries->back().entries;
                 }
-                entries->push_back({text, type, {}});
+                entries->push_back({std::move(text), type, {}});
                 return true;
             }
-            _document.addPart(document_part::List(text, type));
+            _document.emplacePart<document_part::List>(std::move(text), type);
             return true;
         }
     }
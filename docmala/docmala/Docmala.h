@@ -25,6 +25,7 @@
 #include <map>
 #include <fstream>
 #include <memory>
+#include <boost/utility/string_view.hpp>
 
 #include "docmala_global.h"
 #include "Parameter.h"
@@ -36,6 +37,7 @@ class ExtensionSystem;
 }
 namespace docmala {
 class IFile;
+class MemoryFile;
 class DocumentPlugin;
 class OutputPlugin;
 
@@ -46,14 +48,34 @@ public:
     ~Docmala();
 
     void setParameters(const ParameterList& parameters);
+
+    /**
+     * @brief Allocates the parsed document from an arena, see Document::useArena.
+     */
+    void useArena(bool enable);
     bool parseFile(const std::string& fileName);
-    bool parseData(const std::string& data, const std::string& fileName = "");
+    /**
+     * @brief Parses data in place without copying it. data has to stay valid while parsing.
+     */
+    bool parseData(boost::string_view data, const std::string& fileName = "");
 
     bool produceOutput(const std::string& pluginName);
     bool produceOutput(const std::shared_ptr<OutputPlugin>& plugin);
 
     std::vector<std::string> listOutputPlugins() const;
 
+    /**
+     * @brief Versions of all available plugins, keyed by "document/<name>" and "output/<name>".
+     */
+    std::map<std::string, unsigned int> pluginVersions() const;
+
+    /**
+     * @brief Files written by the output plugins since the last parse.
+     */
+    const std::vector<std::string>& outputFiles() const {
+        return _outputFiles;
+    }
+
     std::vector<Error> errors() const {
         return _errors;
     }
@@ -62,17 +84,43 @@ public:
         return _document;
     }
 
+    /**
+     * @brief Moves the parsed document out of the parser, e.g. to insert its parts into another document.
+     *        The parser keeps its arena setting for the next parse.
+     */
+    Document takeDocument() {
+        Document result = std::move(_document);
+        _document.useArena(result.arena() != nullptr);
+        return result;
+    }
+
+    /**
+     * @brief Moves the errors of the last parse out of the parser.
+     */
+    std::vector<Error> takeErrors() {
+        std::vector<Error> result;
+        result.swap(_errors);
+        return result;
+    }
+
     const std::string& pluginDir() const {
         return _pluginDir;
     }
     void readComment();
 
+    static bool readText(MemoryFile* file, std::vector<Error>& errors, char startCharacter, document_part::Text& text);
+    /**
+     * @brief Reads text from any IFile implementation. MemoryFiles are parsed in place,
+     *        other files are read up to the end of the line and parsed from a copy.
+     */
     static bool readText(IFile* file, std::vector<Error>& errors, char startCharacter, document_part::Text& text);
 
 private:
     bool parse();
+    void deferProcessing(const std::shared_ptr<DocumentPlugin>& plugin, const ParameterList& parameters, const FileLocation& location, const std::string& block);
+    void collectDeferredProcessing();
     void doPostprocessing();
-    void postProcessPartList(const std::vector<document_part::Variant>& parts);
+    void postProcessPartList(const document_part::PartList& parts);
     void checkConsistency();
 
     bool readHeadLine();
@@ -80,9 +128,9 @@ private:
     bool readLine(std::string& destination);
     bool readPlugin();
     // bool readAnchor();
-    static bool readAnchor(IFile* file, std::vector<Error>& errors, document_part::Text& outText);
+    static bool readAnchor(MemoryFile* file, std::vector<Error>& errors, document_part::Text& outText);
     bool        readLink(document_part::Text& outText);
-    static bool readLink(IFile* file, std::vector<Error>& errors, document_part::Text& outText);
+    static bool readLink(MemoryFile* file, std::vector<Error>& errors, document_part::Text& outText);
     bool        readMetaData();
     bool        readText(char startCharacter, document_part::Text& text);
 
@@ -92,16 +140,24 @@ private:
 
     static bool isWhitespace(char c, bool allowEndline = false);
 
+    // destroyed after the document, it may keep objects of the plugins alive (see Document::keepAlive)
+    std::shared_ptr<extension_system::ExtensionSystem> _pluginLoader;
+
+    /**
+     * Plugin instances of this parser. The loader is shared by all parsers of a plugin directory, the instances are not:
+     * plugins keep state per document (e.g. the placeholders of PlantUML) and a nested parser runs concurrently with its
+     * parent. The include plugin pools its nested parsers, so their instances are reused.
+     */
+    std::map<std::string, std::shared_ptr<DocumentPlugin>> _loadedDocumentPlugins;
+
     /**
      * A document consists of many document parts
      * All of these parts are stored in this variable
      */
     Document                                               _document;
-    std::unique_ptr<IFile>                                 _file;
+    std::unique_ptr<MemoryFile>                            _file;
     std::vector<Error>                                     _errors;
-    std::unique_ptr<extension_system::ExtensionSystem>     _pluginLoader;
     std::string                                            _outputDir;
-    std::map<std::string, std::shared_ptr<DocumentPlugin>> _loadedDocumentPlugins;
     ParameterList                                          _parameters;
 
     struct PostProcessingInfo {
@@ -111,7 +167,11 @@ private:
         bool                            processed = false;
     };
 
-    std::vector<PostProcessingInfo> _registeredPostprocessing;
-    std::string                     _pluginDir;
+    struct DeferredProcessing;
+
+    std::vector<PostProcessingInfo>                  _registeredPostprocessing;
+    std::vector<std::shared_ptr<DeferredProcessing>> _deferredProcessing;
+    std::string                                      _pluginDir;
+    std::vector<std::string>                         _outputFiles;
 };
 }
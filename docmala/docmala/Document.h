@@ -23,7 +23,11 @@
 #include "DocumentPart.h"
 #include "MetaData.h"
 #include <boost/hana.hpp>
+#include <cstdint>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <set>
 #include <vector>
 
 namespace docmala {
@@ -35,11 +39,80 @@ auto make_visitor(TFs&&... fs) {
 
 class Document {
 public:
+    Document() {
+        reset(false);
+    }
+
+    ~Document() {
+        releaseParts();
+    }
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    Document(Document&& other)
+        : Document() {
+        swap(other);
+    }
+
+    Document& operator=(Document&& other) {
+        Document(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void swap(Document& other) {
+        std::swap(_arenas, other._arenas);
+        std::swap(_partsInArena, other._partsInArena);
+        std::swap(_parts, other._parts);
+        std::swap(_anchors, other._anchors);
+        std::swap(_metaData, other._metaData);
+        std::swap(_dependencies, other._dependencies);
+        std::swap(_dependencyHashes, other._dependencyHashes);
+        std::swap(_keptAlive, other._keptAlive);
+    }
+
+    /**
+     * @brief Discards the content and allocates all parts of this document from an Arena, that is owned
+     *        by the document and released as a whole, without destroying the parts one by one.
+     *        The arena is used by Docmala while parsing into this document.
+     */
+    void useArena(bool enable) {
+        reset(enable);
+    }
+
+    Arena* arena() const {
+        return _arenas.empty() ? nullptr : _arenas.front().get();
+    }
+
+    /**
+     * @brief Adds part to the end of the document.
+     *        Parts of a document using an arena are never destroyed, so a part moved in must have been
+     *        allocated from the arena of this document (the current arena while parsing). Moving in a part
+     *        built from the heap, e.g. outside of Arena::Scope, leaks its strings and vectors. Such parts have to be
+     *        added as copies, while the arena of this document is current.
+     */
     void addPart(const document_part::Variant& part) {
-        _parts.push_back(part);
+        _parts->push_back(part);
         addAnchors(part);
     }
 
+    void addPart(document_part::Variant&& part) {
+        _parts->push_back(std::move(part));
+        addAnchors(_parts->back());
+    }
+
+    /**
+     * @brief Constructs a part of type T from args, moves it to the end of the document and returns it.
+     *        Anchors are registered right away, so the part has to be complete when passed in.
+     *        Like for addPart, strings and vectors moved in have to come from the arena of this document.
+     */
+    template <typename T, typename... Args>
+    T& emplacePart(Args&&... args) {
+        _parts->emplace_back(T(std::forward<Args>(args)...));
+        addAnchors(_parts->back());
+        return boost::get<T>(_parts->back());
+    }
+
     void addMetaData(const MetaData& metaData) {
         auto& data = _metaData[metaData.key];
         if (data.mode == MetaData::Mode::None) {
@@ -50,37 +123,86 @@ public:
         }
     }
 
+    /**
+     * @brief Records a file the document was generated from (the input, included files, images, ...).
+     *        A dependency without a content hash is treated like a missing file, e.g. by BuildCache.
+     */
+    void addDependency(const std::string& fileName) {
+        _dependencies.insert(fileName);
+    }
+
+    /**
+     * @brief Records a file the document was generated from together with the hash of the content,
+     *        that was read (see hash::compute), so later changes of the file are not mistaken as built.
+     */
+    void addDependency(const std::string& fileName, std::uint64_t contentHash) {
+        _dependencies.insert(fileName);
+        _dependencyHashes[fileName] = contentHash;
+    }
+
+    const std::set<std::string>& dependencies() const {
+        return _dependencies;
+    }
+
+    const std::map<std::string, std::uint64_t>& dependencyHashes() const {
+        return _dependencyHashes;
+    }
+
+    /**
+     * @brief Keeps owner alive as long as the parts of this document, e.g. the document a GeneratedDocument
+     *        shares its parts with. Shared parts are never modified, a plugin rewriting them works on a copy.
+     */
+    void keepAlive(std::shared_ptr<const void> owner) {
+        _keptAlive.push_back(std::move(owner));
+    }
+
     void inheritFrom(const Document& other) {
         _anchors = other.anchors();
     }
 
+    /**
+     * @brief Takes over anchors, meta data, dependencies, the arenas and the kept alive owners of other, whose parts
+     *        are moved into this document. The moved parts stay in the arenas of other, which are released with this document.
+     */
+    void mergeFrom(Document& other) {
+        _anchors.insert(other._anchors.begin(), other._anchors.end());
+        for (auto& entry : other._metaData) {
+            mergeMetaData(std::move(entry.second));
+        }
+        _dependencies.insert(other._dependencies.begin(), other._dependencies.end());
+        _dependencyHashes.insert(other._dependencyHashes.begin(), other._dependencyHashes.end());
+        std::move(other._arenas.begin(), other._arenas.end(), std::back_inserter(_arenas));
+        other._arenas.clear();
+        std::move(other._keptAlive.begin(), other._keptAlive.end(), std::back_inserter(_keptAlive));
+        other._keptAlive.clear();
+    }
+
     void clear() {
-        _parts.clear();
-        _anchors.clear();
+        reset(arena() != nullptr);
     }
 
     bool empty() const {
-        return _parts.empty();
+        return _parts->empty();
     }
 
     document_part::Variant& last() {
-        return _parts.back();
+        return _parts->back();
     }
 
     template< typename T>
     T* last() {
-        if( _parts.empty() )
+        if( _parts->empty() )
             return nullptr;
 
-        return boost::get<T>(&_parts.back());
+        return boost::get<T>(&_parts->back());
     }
 
-    std::vector<document_part::Variant>& parts() {
-        return _parts;
+    document_part::PartList& parts() {
+        return *_parts;
     }
 
-    const std::vector<document_part::Variant>& parts() const {
-        return _parts;
+    const document_part::PartList& parts() const {
+        return *_parts;
     }
 
     const std::map<std::string, document_part::Anchor>& anchors() const {
@@ -92,12 +214,54 @@ public:
     }
 
 private:
+    /**
+     * @brief Adds all values of metaData with the rules of addMetaData.
+     */
+    void mergeMetaData(MetaData&& metaData) {
+        auto& data = _metaData[metaData.key];
+        if (data.mode == MetaData::Mode::None) {
+            data = std::move(metaData);
+        } else if (data.mode == MetaData::Mode::List) {
+            std::move(metaData.data.begin(), metaData.data.end(), std::back_inserter(data.data));
+        }
+    }
+
+    void reset(bool useArena) {
+        // anchors may refer to the arenas, so they go first
+        _anchors.clear();
+        _metaData.clear();
+        _dependencies.clear();
+        _dependencyHashes.clear();
+        releaseParts();
+        _arenas.clear();
+        _keptAlive.clear();
+
+        if (useArena) {
+            _arenas.push_back(std::make_unique<Arena>());
+            auto arena    = _arenas.front().get();
+            auto memory   = arena->allocate(sizeof(document_part::PartList), alignof(document_part::PartList));
+            _parts        = new (memory) document_part::PartList(ArenaAllocator<document_part::Variant>(arena));
+            _partsInArena = true;
+        } else {
+            _parts        = new document_part::PartList(ArenaAllocator<document_part::Variant>(nullptr));
+            _partsInArena = false;
+        }
+    }
+
+    void releaseParts() {
+        // parts in an arena are not destroyed one by one, their memory is released with the arena
+        if (!_partsInArena) {
+            delete _parts;
+        }
+        _parts = nullptr;
+    }
+
     void addAnchors(const document_part::Variant& part) {
         auto visitor = make_visitor(
             // visitors
             [this](const document_part::Anchor& anchor) { _anchors.insert(std::make_pair(anchor.name, anchor)); },
             [this](const document_part::GeneratedDocument& doc) {
-                for (const auto& p : doc.document) {
+                for (const auto& p : doc.parts()) {
                     addAnchors(p);
                 }
             },
@@ -119,8 +283,13 @@ private:
         boost::apply_visitor(visitor, part);
     }
 
-    std::vector<document_part::Variant>          _parts;
+    std::vector<std::unique_ptr<Arena>>          _arenas; // the own arena first, then the ones taken over by mergeFrom
+    bool                                         _partsInArena = false;
+    document_part::PartList*                     _parts        = nullptr;
     std::map<std::string, document_part::Anchor> _anchors;
     std::map<std::string, MetaData>             _metaData;
+    std::set<std::string>                       _dependencies;
+    std::map<std::string, std::uint64_t>        _dependencyHashes; ///< content hashes taken when the files were read
+    std::vector<std::shared_ptr<const void>>    _keptAlive;        ///< owners of shared parts, see keepAlive
 };
 } // namespace docmala
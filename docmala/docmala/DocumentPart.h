@@ -20,6 +20,7 @@
  */
 #pragma once
 
+#include "Arena.h"
 #include "FileLocation.h"
 #include <boost/variant/get.hpp>
 #include <boost/variant/variant.hpp>
@@ -45,6 +46,60 @@ struct Paragraph;
 
 using Variant = boost::variant<Text, FormatedText, Caption, Headline, Image, List, Anchor, Link, GeneratedDocument, Code, Table, Paragraph>;
 
+/**
+ * @brief Vector type of the document tree, its memory comes from the current Arena (or the heap).
+ */
+template <typename T>
+using Vector = std::vector<T, ArenaAllocator<T>>;
+
+using PartList = Vector<Variant>;
+
+/**
+ * @brief String type of the document tree, its memory comes from the current Arena (or the heap).
+ *        Converts implicitly from and to std::string.
+ */
+class String : public std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> {
+public:
+    using Base = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+    using Base::Base;
+
+    String() = default;
+
+    String(const Base& other)
+        : Base(other) {}
+
+    String(Base&& other)
+        : Base(std::move(other)) {}
+
+    String(const std::string& other)
+        : Base(other.data(), other.size()) {}
+
+    String substr(size_type position = 0, size_type count = npos) const {
+        return Base::substr(position, count);
+    }
+
+    operator std::string() const {
+        return std::string(data(), size());
+    }
+};
+
+// concatenation with document strings yields plain std::strings, e.g. for messages
+inline std::string operator+(const std::string& left, const String& right) {
+    return left + std::string(right);
+}
+
+inline std::string operator+(const String& left, const std::string& right) {
+    return std::string(left) + right;
+}
+
+inline std::string operator+(const char* left, const String& right) {
+    return left + std::string(right);
+}
+
+inline std::string operator+(const String& left, const char* right) {
+    return std::string(left) + right;
+}
+
 struct VisualElement {
     VisualElement(const FileLocation& location)
         : location(location) {}
@@ -56,7 +111,7 @@ struct Table : public VisualElement {
         : VisualElement(location) {}
 
     struct Cell {
-        std::vector<document_part::Variant> content;
+        PartList content;
 
         size_t columnSpan     = 0;
         size_t rowSpan        = 0;
@@ -64,21 +119,21 @@ struct Table : public VisualElement {
         bool   isHiddenBySpan = false;
     };
 
-    size_t                         columns = 0;
-    size_t                         rows    = 0;
-    std::vector<std::vector<Cell>> cells;
+    size_t               columns = 0;
+    size_t               rows    = 0;
+    Vector<Vector<Cell>> cells;
 };
 
 struct Anchor {
-    std::string  name;
+    String       name;
     FileLocation location;
 };
 
 struct Link {
     enum class Type { Web, IntraFile, InterFile };
 
-    std::string  data;
-    std::string  text;
+    String       data;
+    String       text;
     Type         type;
     FileLocation location;
 };
@@ -88,34 +143,45 @@ struct Paragraph {};
 struct Code : public VisualElement {
     Code(const FileLocation& location)
         : VisualElement(location) {}
-    std::string code;
-    std::string type;
+    String code;
+    String type;
 };
 
 struct FormatedText {
     FormatedText() {}
     FormatedText(const std::string& text)
         : text(text) {}
-
-    std::string text;
-    bool        bold       = false;
-    bool        italic     = false;
-    bool        monospaced = false;
-    bool        stroked    = false;
-    bool        underlined = false;
+    FormatedText(String&& text)
+        : text(std::move(text)) {}
+
+    String text;
+    bool   bold       = false;
+    bool   italic     = false;
+    bool   monospaced = false;
+    bool   stroked    = false;
+    bool   underlined = false;
 };
 
 struct GeneratedDocument : public VisualElement {
     GeneratedDocument(const FileLocation& location)
         : VisualElement(location) {}
-    std::vector<document_part::Variant> document;
+
+    /**
+     * @return the shared parts, if there are any, otherwise the own ones
+     */
+    const PartList& parts() const {
+        return shared != nullptr ? *shared : document;
+    }
+
+    PartList        document;
+    const PartList* shared = nullptr; ///< parts of another document, that are not copied (see Document::keepAlive)
 };
 
 struct Text : public VisualElement {
     Text(const FileLocation& location = FileLocation())
         : VisualElement(location) {}
 
-    std::vector<document_part::Variant> text;
+    PartList text;
 };
 
 struct Headline : public Text {
@@ -124,6 +190,9 @@ struct Headline : public Text {
     Headline(const Text& text, int level)
         : Text(text)
         , level(level) {}
+    Headline(Text&& text, int level)
+        : Text(std::move(text))
+        , level(level) {}
 
     int level = 0;
 };
@@ -134,30 +203,35 @@ struct List {
     List() {}
     List(const Text& text, Type type)
         : entries({{text, type, {}}}) {}
+    List(Text&& text, Type type) {
+        entries.push_back({std::move(text), type, {}});
+    }
     struct Entry {
-        Text               text;
-        Type               type = Type::Points;
-        std::vector<Entry> entries;
+        Text          text;
+        Type          type = Type::Points;
+        Vector<Entry> entries;
     };
-    std::vector<Entry> entries;
+    Vector<Entry> entries;
 };
 
 struct Caption : public Text {
     Caption() = default;
     Caption(const Text& text)
         : Text(text) {}
+    Caption(Text&& text)
+        : Text(std::move(text)) {}
 };
 
 struct Image : public Text {
     Image() = default;
-    Image(const std::string& format, const std::string& fileExtension, const std::string& data, const Text& text)
-        : Text(text)
-        , format(format)
-        , fileExtension(fileExtension)
-        , data(data) {}
-    std::string format;
-    std::string fileExtension;
-    std::string data;
+    Image(String format, String fileExtension, String data, Text text)
+        : Text(std::move(text))
+        , format(std::move(format))
+        , fileExtension(std::move(fileExtension))
+        , data(std::move(data)) {}
+    String format;
+    String fileExtension;
+    String data;
 };
 
 } // namespace DocumentPart
@@ -29,74 +29,94 @@ IFile::~IFile() = default;
 MemoryFile::MemoryFile(const std::string& data, const std::string& fileName)
     : _data(data)
     , _fileName(fileName)
-    , _position(_data.begin()) {}
+    , _file(FileNames::intern(fileName)) {
+    setData(_data.data(), _data.data() + _data.size());
+}
 
 MemoryFile::MemoryFile(const std::string& data, const FileLocation& baseLocation)
     : _data(data)
-    , _fileName(baseLocation.fileName)
-    , _position(_data.begin())
-    , _line(baseLocation.line)
-    , _column(baseLocation.column) {}
-
-bool MemoryFile::isOpen() const {
-    return !_data.empty();
+    , _fileName(baseLocation.fileName())
+    , _file(baseLocation.file)
+    , _baseLine(baseLocation.line)
+    , _baseColumn(baseLocation.column) {
+    setData(_data.data(), _data.data() + _data.size());
 }
 
-bool MemoryFile::isEoF() const {
-    return _position >= _data.end();
-}
-
-char MemoryFile::getch() {
-    _previous[0] = _previous[1];
-    char c       = _getch();
-    _previous[1] = c;
-    return c;
+bool MemoryFile::isOpen() const {
+    return _begin != _end;
 }
 
-char MemoryFile::previous() {
-    return _previous[0];
+FileLocation MemoryFile::location() const {
+    return location(_lastOffset);
 }
 
-char MemoryFile::following() {
-    auto pos        = _position;
-    auto line       = _line;
-    auto column     = _column;
-    char previous[] = {_previous[0], _previous[1]};
-    auto next       = getch();
+FileLocation MemoryFile::location(Offset offset) const {
+    if (offset < 0) {
+        return FileLocation{_baseLine, _baseColumn, _file};
+    }
+    buildLineIndex();
 
-    _line        = line;
-    _column      = column;
-    _position    = pos;
-    _previous[0] = previous[0];
-    _previous[1] = previous[1];
+    // the first line continues the base location, all following lines start at column 0
+    const auto lineIndex = std::upper_bound(_lineStarts.begin(), _lineStarts.end(), offset) - _lineStarts.begin();
+    const auto lineStart = lineIndex == 0 ? 0 : _lineStarts[static_cast<size_t>(lineIndex - 1)];
+    const auto lineEnd   = std::min(offset + 1, _end - _begin);
 
-    return next;
-}
+    const auto carriageReturns = std::lower_bound(_carriageReturns.begin(), _carriageReturns.end(), lineEnd)
+                                 - std::lower_bound(_carriageReturns.begin(), _carriageReturns.end(), lineStart);
+    const auto characters = offset + 1 - lineStart - carriageReturns;
 
-FileLocation MemoryFile::location() const {
-    return FileLocation{_line, _column, _fileName};
+    if (lineIndex == 0) {
+        return FileLocation{_baseLine, _baseColumn + static_cast<int>(characters), _file};
+    }
+    return FileLocation{_baseLine + static_cast<int>(lineIndex), static_cast<int>(characters) - 1, _file};
 }
 
 std::string MemoryFile::fileName() const {
     return _fileName;
 }
 
-MemoryFile::MemoryFile()
-    : _position(_data.end()) {}
+MemoryFile::MemoryFile() = default;
 
-char MemoryFile::_getch() {
-    char c = *_position;
-    _position++;
-    if (c == '\r') {
-        return _getch();
+void MemoryFile::buildLineIndex() const {
+    if (_lineIndexBuilt) {
+        return;
     }
-    if (previous() == '\n') {
-        _line++;
-        _column = 0;
-    } else {
-        _column++;
+    _lineIndexBuilt = true;
+
+    static const scanner::CharacterSet lineCharacters("\n\r");
+
+    for (const char* p = scanner::findFirstOf(_begin, _end, lineCharacters); p != _end;
+         p             = scanner::findFirstOf(p + 1, _end, lineCharacters)) {
+        if (*p == '\n') {
+            _lineStarts.push_back(p + 1 - _begin);
+        } else {
+            _carriageReturns.push_back(p - _begin);
+        }
     }
-    return c;
+}
+
+void MemoryFile::setData(const char* begin, const char* end) {
+    _begin          = begin;
+    _end            = end;
+    _position       = begin;
+    _lastOffset     = -1;
+    _lineIndexBuilt = false;
+    _lineStarts.clear();
+    _carriageReturns.clear();
+}
+
+MemoryFileView::MemoryFileView(boost::string_view data, const std::string& fileName) {
+    _fileName = fileName;
+    _file     = FileNames::intern(fileName);
+    setData(data.data(), data.data() + data.size());
+}
+
+MemoryFileView::MemoryFileView(boost::string_view data, const FileLocation& baseLocation) {
+    _fileName   = baseLocation.fileName();
+    _file       = baseLocation.file;
+    _baseLine   = baseLocation.line;
+    _baseColumn = baseLocation.column;
+    setData(data.data(), data.data() + data.size());
 }
 
 File::File(const std::string& fileName) {
@@ -105,14 +125,16 @@ File::File(const std::string& fileName) {
     }
 
     _fileName = fileName;
+    _file     = FileNames::intern(fileName);
+
+    try {
+        _mapping.open(fileName);
+    } catch (const std::exception&) {
+        // a missing or empty file is reported through isOpen()
+        return;
+    }
 
-    std::ifstream in(fileName, std::ios::in | std::ios::binary);
-    if (in.is_open()) {
-        in.seekg(0, std::ios::end);
-        _data.resize(static_cast<std::string::size_type>(in.tellg()));
-        in.seekg(0, std::ios::beg);
-        in.read(&_data[0], static_cast<std::streamsize>(_data.size()));
-        in.close();
-        _position = _data.begin();
+    if (_mapping.is_open()) {
+        setData(_mapping.data(), _mapping.data() + _mapping.size());
     }
 }
@@ -21,9 +21,14 @@
 #pragma once
 
 #include "docmala_global.h"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/utility/string_view.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <string>
-#include <fstream>
+#include <vector>
 #include "FileLocation.h"
+#include "Scanner.h"
 
 namespace docmala {
 
@@ -41,41 +46,10 @@ public:
     virtual std::string  fileName() const = 0;
 };
 
-//    class File : public IFile {
-//    public:
-//        File( ) {
-//        }
-
-//        explicit File( const std::string &fileName );
-
-//        bool isOpen() const override {
-//            return _file.is_open();
-//        }
-
-//        bool isEoF() const override {
-//            return _fileIterator >= _file.end();
-//        }
-
-//        char getch() override;
-
-//        char previous() override;
-//        char following() override;
-
-//        FileLocation location() const override;
-
-//    private:
-//        char _getch();
-
-//        int _line = 1;
-//        int _column = 0;
-
-//        boost::iostreams::mapped_file::iterator _fileIterator;
-
-//        char _previous[2] = {0};
-//        std::string _fileName;
-//        boost::iostreams::mapped_file _file;
-//    };
-
+/**
+ * @brief A file, whose content is available as one contiguous buffer.
+ *        Besides the IFile interface it offers a non-virtual fast path, that is used by the parser.
+ */
 class DOCMALA_API MemoryFile : public IFile {
 
 public:
@@ -83,29 +57,199 @@ public:
     MemoryFile(const std::string& data, const FileLocation& baseLocation);
     bool isOpen() const override;
 
-    bool         isEoF() const override;
-    char         getch() override;
-    char         previous() override;
-    char         following() override;
+    bool isEoF() const final {
+        return _position >= _end;
+    }
+
+    char getch() final {
+        _previous[0] = _previous[1];
+        char c       = _getch();
+        _previous[1] = c;
+        return c;
+    }
+
+    /**
+     * @brief Identifies a character by its byte offset. Offsets are cheap to store while parsing
+     *        and are resolved to a FileLocation only when needed.
+     */
+    using Offset = std::ptrdiff_t;
+
+    /**
+     * @brief Returns the offset of the last consumed character, -1 if nothing has been consumed yet.
+     */
+    Offset offset() const {
+        return _lastOffset;
+    }
+
+    char previous() final {
+        return _previous[0];
+    }
+
+    char following() final {
+        return peek();
+    }
+
     FileLocation location() const override;
     std::string  fileName() const override;
 
+    /**
+     * @brief Returns the whole content of the file.
+     */
+    boost::string_view data() const {
+        return boost::string_view(_begin, static_cast<std::size_t>(_end - _begin));
+    }
+
+    /**
+     * @brief Resolves an offset to line and column. The line index is built on first use,
+     *        every lookup afterwards is O(log n).
+     */
+    FileLocation location(Offset offset) const;
+
+    /**
+     * @brief Returns the n-th character after the current position without consuming it.
+     *        '\r' is skipped like in getch(), '\0' is returned beyond the end of the file.
+     */
+    char peek(size_t n = 0) const {
+        for (const char* p = _position; p < _end; p++) {
+            if (*p == '\r') {
+                continue;
+            }
+            if (n == 0) {
+                return *p;
+            }
+            n--;
+        }
+        return '\0';
+    }
+
+    /**
+     * @brief Consumes all characters up to, but not including, the next occurrence of c.
+     * @return true if c was found, false if the end of the file was reached
+     */
+    bool skipUntil(char c) {
+        const char* p = scanner::findFirstOf(_position, _end, scanner::CharacterSet(boost::string_view(&c, 1)));
+        advanceTo(p);
+        return p != _end;
+    }
+
+    /**
+     * @brief Consumes all characters up to, but not including, the next one of stopCharacters
+     *        and appends them to destination.
+     */
+    template <typename String>
+    void takeUntil(boost::string_view stopCharacters, String& destination) {
+        scanner::CharacterSet characters(stopCharacters);
+        characters.add('\r');
+
+        const char* p = _position;
+        while (true) {
+            const char* stop = scanner::findFirstOf(p, _end, characters);
+            destination.append(p, stop);
+            if (stop == _end || *stop != '\r') {
+                p = stop;
+                break;
+            }
+            p = stop + 1;
+        }
+        advanceTo(p);
+    }
+
+    /**
+     * @brief Consumes characters as long as predicate returns true and appends them to destination.
+     */
+    template <typename Predicate, typename String>
+    void takeWhile(Predicate predicate, String& destination) {
+        const char* runBegin = _position;
+        const char* p        = _position;
+        for (; p < _end; p++) {
+            if (*p == '\r') {
+                destination.append(runBegin, p);
+                runBegin = p + 1;
+                continue;
+            }
+            if (!predicate(*p)) {
+                break;
+            }
+        }
+        destination.append(runBegin, p);
+        advanceTo(p);
+    }
+
 protected:
     MemoryFile();
-    std::string           _data;
-    std::string           _fileName;
-    std::string::iterator _position;
+    void setData(const char* begin, const char* end);
+
+    std::string _data; ///< owned storage, stays empty if the data is borrowed
+    std::string _fileName;
+    FileId      _file       = FileNames::intern("");
+    const char* _begin      = nullptr;
+    const char* _end        = nullptr;
+    const char* _position   = nullptr;
+    int         _baseLine   = 1;
+    int         _baseColumn = 0;
 
 private:
-    char _getch();
+    char _getch() {
+        while (_position < _end && *_position == '\r') {
+            _position++;
+        }
+        if (_position >= _end) {
+            // reading beyond the end yields '\0', mapped memory may end exactly at _end
+            _lastOffset = std::max(_lastOffset + 1, _end - _begin);
+            return '\0';
+        }
+        _lastOffset = _position - _begin;
+        return *_position++;
+    }
+
+    void advanceTo(const char* position) {
+        // only the last two consumed characters are of interest, '\r' is skipped like in getch()
+        int found = 0;
+        for (const char* p = position; p > _position && found < 2;) {
+            p--;
+            if (*p == '\r') {
+                continue;
+            }
+            if (found == 0) {
+                _lastOffset  = p - _begin;
+                _previous[0] = _previous[1];
+                _previous[1] = *p;
+            } else {
+                _previous[0] = *p;
+            }
+            found++;
+        }
+        _position = position;
+    }
+
+    void buildLineIndex() const;
+
+    char   _previous[2] = {0};
+    Offset _lastOffset  = -1;
+
+    mutable bool                _lineIndexBuilt = false;
+    mutable std::vector<Offset> _lineStarts;      ///< offsets of all characters following a '\n'
+    mutable std::vector<Offset> _carriageReturns; ///< offsets of all '\r', they do not count as columns
+};
 
-    int  _line        = 1;
-    int  _column      = 0;
-    char _previous[2] = {0};
+/**
+ * @brief A MemoryFile that parses the given data in place instead of copying it.
+ *        The data has to outlive the MemoryFileView.
+ */
+class DOCMALA_API MemoryFileView : public MemoryFile {
+public:
+    MemoryFileView(boost::string_view data, const std::string& fileName = "");
+    MemoryFileView(boost::string_view data, const FileLocation& baseLocation);
 };
 
+/**
+ * @brief A file, that is memory mapped and parsed in place.
+ */
 class DOCMALA_API File : public MemoryFile {
 public:
     explicit File(const std::string& fileName);
+
+private:
+    boost::iostreams::mapped_file_source _mapping;
 };
 }
@@ -0,0 +1,116 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FileLocation.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace docmala;
+
+namespace {
+/**
+ * @brief Names are stored in chunks, that are never moved or freed while the process runs. Chunk k holds
+ *        firstChunkSize << k names, so a few chunks cover all ids and a name is found without locking.
+ */
+struct FileNameTable {
+    static const FileId      firstChunkSize = 64;
+    static const std::size_t maximumChunks  = 26; // more than 2^32 names
+
+    FileNameTable() {
+        append("internal");
+    }
+
+    ~FileNameTable() {
+        for (auto& chunk : chunks) {
+            delete[] chunk.load();
+        }
+    }
+
+    static void locate(FileId id, std::size_t& chunk, FileId& index) {
+        chunk          = 0;
+        FileId size    = firstChunkSize;
+        FileId chunkId = id;
+        while (chunkId >= size) {
+            chunkId -= size;
+            size *= 2;
+            chunk++;
+        }
+        index = chunkId;
+    }
+
+    // called with mutex held
+    FileId append(const std::string& fileName) {
+        const auto  id = count.load(std::memory_order_relaxed);
+        std::size_t chunk;
+        FileId      index;
+        locate(id, chunk, index);
+
+        auto names = chunks[chunk].load(std::memory_order_relaxed);
+        if (names == nullptr) {
+            names = new std::string[static_cast<std::size_t>(firstChunkSize) << chunk];
+            chunks[chunk].store(names, std::memory_order_release);
+        }
+        names[index] = fileName;
+        ids.emplace(fileName, id);
+
+        // publishes the name to resolve
+        count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    const std::string& resolve(FileId id) const {
+        if (id >= count.load(std::memory_order_acquire)) {
+            id = 0;
+        }
+        std::size_t chunk;
+        FileId      index;
+        locate(id, chunk, index);
+        return chunks[chunk].load(std::memory_order_acquire)[index];
+    }
+
+    std::mutex                              mutex; ///< serializes intern, resolve does not lock
+    std::atomic<std::string*>               chunks[maximumChunks] = {};
+    std::atomic<FileId>                     count{0};
+    std::unordered_map<std::string, FileId> ids;
+};
+
+FileNameTable& table() {
+    static FileNameTable fileNames;
+    return fileNames;
+}
+} // namespace
+
+FileId FileNames::intern(const std::string& fileName) {
+    auto&                       fileNames = table();
+    std::lock_guard<std::mutex> lock(fileNames.mutex);
+
+    auto existing = fileNames.ids.find(fileName);
+    if (existing != fileNames.ids.end()) {
+        return existing->second;
+    }
+    return fileNames.append(fileName);
+}
+
+const std::string& FileNames::resolve(FileId id) {
+    return table().resolve(id);
+}
@@ -20,35 +20,63 @@
  */
 #pragma once
 
+#include "docmala_global.h"
+#include <cstdint>
+#include <functional>
 #include <string>
 
 namespace docmala {
 
+/**
+ * @brief Identifies an interned file name, 0 is the "internal" location.
+ */
+using FileId = std::uint32_t;
+
+/**
+ * @brief Process wide table of interned file names.
+ *        Ids are never reused, so locations stay valid across nested parsers and plugins.
+ *        The table only grows and lives as long as the process, resolving an id does not lock.
+ */
+class DOCMALA_API FileNames {
+public:
+    static FileId             intern(const std::string& fileName);
+    static const std::string& resolve(FileId id);
+};
+
 struct FileLocation {
+    FileLocation(int line, int column, FileId file)
+        : line(line)
+        , column(column)
+        , file(file) {}
+
     FileLocation(int line, int column, const std::string& fileName)
         : line(line)
         , column(column)
-        , fileName(fileName) {}
+        , file(FileNames::intern(fileName)) {}
 
-    FileLocation()       = default;
-    int         line     = 0;
-    int         column   = 0;
-    std::string fileName = "internal";
+    FileLocation()   = default;
+    int    line   = 0;
+    int    column = 0;
+    FileId file   = 0;
+
+    const std::string& fileName() const {
+        return FileNames::resolve(file);
+    }
 
     bool valid() const {
         return line != 0;
     }
 
     bool operator<(const FileLocation& other) const {
-        if (fileName != other.fileName)
-            return fileName < other.fileName;
+        if (file != other.file)
+            return file < other.file;
         if (line != other.line)
             return line < other.line;
         return column < other.column;
     }
 
     bool operator==(const FileLocation& other) const {
-        return line == other.line && column == other.column && fileName == other.fileName;
+        return line == other.line && column == other.column && file == other.file;
     }
 
     bool operator!=(const FileLocation& other) const {
@@ -56,3 +84,14 @@ struct FileLocation {
     }
 };
 }
+
+namespace std {
+template <>
+struct hash<docmala::FileLocation> {
+    size_t operator()(const docmala::FileLocation& location) const {
+        const auto lineAndColumn = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(location.line)) << 32)
+                                   | static_cast<std::uint32_t>(location.column);
+        return std::hash<std::uint64_t>()(lineAndColumn) ^ (std::hash<docmala::FileId>()(location.file) * 31);
+    }
+};
+}
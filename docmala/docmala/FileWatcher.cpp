@@ -0,0 +1,130 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace docmala;
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+    : _inotify(inotify_init1(IN_CLOEXEC)) {}
+
+FileWatcher::~FileWatcher() {
+    if (_inotify >= 0) {
+        close(_inotify);
+    }
+}
+
+bool FileWatcher::isSupported() const {
+    return _inotify >= 0;
+}
+
+bool FileWatcher::watch(const std::string& fileName) {
+    if (_inotify < 0) {
+        return false;
+    }
+
+    const auto  separator = fileName.find_last_of('/');
+    std::string directory = separator == std::string::npos ? "." : fileName.substr(0, separator);
+    std::string name      = separator == std::string::npos ? fileName : fileName.substr(separator + 1);
+    if (directory.empty()) {
+        directory = "/";
+    }
+
+    // the same directory always yields the same descriptor, regardless of its spelling
+    const int descriptor = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    _watches[descriptor][name].insert(fileName);
+    return true;
+}
+
+std::set<std::string> FileWatcher::waitForChanges(std::chrono::milliseconds settleTime) {
+    std::set<std::string> changes;
+    if (_inotify < 0) {
+        return changes;
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    pollfd                      request{_inotify, POLLIN, 0};
+
+    while (true) {
+        // wait without limit for the first change, afterwards only until the changes settled
+        const int timeout = changes.empty() ? -1 : static_cast<int>(settleTime.count());
+        const int ready   = poll(&request, 1, timeout);
+        if (ready == 0) {
+            return changes;
+        }
+        if (ready < 0) {
+            continue;
+        }
+
+        const auto length = read(_inotify, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+
+        for (auto position = buffer; position < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(position);
+            position += sizeof(inotify_event) + event->len;
+
+            auto watch = _watches.find(event->wd);
+            if (watch == _watches.end() || event->len == 0) {
+                continue;
+            }
+
+            auto file = watch->second.find(event->name);
+            if (file != watch->second.end()) {
+                changes.insert(file->second.begin(), file->second.end());
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::isSupported() const {
+    return false;
+}
+
+bool FileWatcher::watch(const std::string& fileName) {
+    (void)fileName;
+    return false;
+}
+
+std::set<std::string> FileWatcher::waitForChanges(std::chrono::milliseconds settleTime) {
+    (void)settleTime;
+    return {};
+}
+
+#endif
@@ -0,0 +1,65 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+
+namespace docmala {
+
+/**
+ * @brief Reports modifications of files. Only implemented on Linux (inotify), elsewhere isSupported() is false.
+ *
+ * The directory of a watched file is observed instead of the file itself, so files that editors
+ * replace on save (write to a temporary file and rename) are still noticed.
+ */
+class DOCMALA_API FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool isSupported() const;
+
+    /**
+     * @brief Starts watching fileName, watching a file twice has no effect.
+     * @return false, if the directory of the file can not be watched
+     */
+    bool watch(const std::string& fileName);
+
+    /**
+     * @brief Blocks until a watched file changed. Changes that follow within settleTime are collected as well,
+     *        as saving a file often results in multiple events.
+     * @return The changed files, spelled as they were passed to watch
+     */
+    std::set<std::string> waitForChanges(std::chrono::milliseconds settleTime);
+
+private:
+    int _inotify = -1;
+    // watch descriptor -> file name within the directory -> watched file names
+    std::map<int, std::map<std::string, std::set<std::string>>> _watches;
+};
+} // namespace docmala
@@ -0,0 +1,155 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace docmala;
+
+namespace {
+/**
+ * @brief MurmurHash64A over data, that is passed in consecutive pieces. The size of the whole data
+ *        is part of the initial state, so it has to be known in advance.
+ */
+class Murmur64A {
+public:
+    Murmur64A(std::uint64_t size, std::uint64_t seed)
+        : _result(seed ^ (size * multiplier)) {}
+
+    /**
+     * @brief Hashes all complete blocks of 8 bytes of data.
+     * @return the number of bytes consumed, the rest has to be passed to finish()
+     */
+    std::size_t update(const unsigned char* bytes, std::size_t size) {
+        const auto* end = bytes + (size & ~std::size_t(7));
+
+        for (const auto* block = bytes; block != end; block += 8) {
+            std::uint64_t k;
+            std::memcpy(&k, block, sizeof(k));
+
+            k *= multiplier;
+            k ^= k >> shift;
+            k *= multiplier;
+
+            _result ^= k;
+            _result *= multiplier;
+        }
+        return static_cast<std::size_t>(end - bytes);
+    }
+
+    /**
+     * @brief Hashes the remaining bytes (less than 8) and returns the hash.
+     */
+    std::uint64_t finish(const unsigned char* bytes, std::size_t size) {
+        switch (size & 7) {
+            case 7:
+                _result ^= std::uint64_t(bytes[6]) << 48;
+                // fall through
+            case 6:
+                _result ^= std::uint64_t(bytes[5]) << 40;
+                // fall through
+            case 5:
+                _result ^= std::uint64_t(bytes[4]) << 32;
+                // fall through
+            case 4:
+                _result ^= std::uint64_t(bytes[3]) << 24;
+                // fall through
+            case 3:
+                _result ^= std::uint64_t(bytes[2]) << 16;
+                // fall through
+            case 2:
+                _result ^= std::uint64_t(bytes[1]) << 8;
+                // fall through
+            case 1:
+                _result ^= std::uint64_t(bytes[0]);
+                _result *= multiplier;
+        }
+
+        _result ^= _result >> shift;
+        _result *= multiplier;
+        _result ^= _result >> shift;
+        return _result;
+    }
+
+private:
+    static const std::uint64_t multiplier = 0xc6a4a7935bd1e995ULL;
+    static const int           shift      = 47;
+
+    std::uint64_t _result;
+};
+} // namespace
+
+std::uint64_t hash::compute(const void* data, std::size_t size, std::uint64_t seed) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    Murmur64A  hasher(size, seed);
+    const auto consumed = hasher.update(bytes, size);
+    return hasher.finish(bytes + consumed, size - consumed);
+}
+
+bool hash::computeForFile(const std::string& fileName, std::uint64_t& result) {
+    // the size is part of the hash, it is only known in advance for regular files (not for directories or pipes)
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG) {
+        return false;
+    }
+
+    std::ifstream reader(fileName, std::ios::in | std::ios::binary);
+    if (!reader) {
+        return false;
+    }
+
+    const auto    size = static_cast<std::uint64_t>(info.st_size);
+    Murmur64A     hasher(size, 0);
+    std::uint64_t read = 0;
+
+    // the file is hashed in chunks, every chunk but the last one is a multiple of 8 bytes
+    unsigned char buffer[64 * 1024];
+    std::size_t   pending = 0;
+    while (reader.read(reinterpret_cast<char*>(buffer), sizeof(buffer)) || reader.gcount() > 0) {
+        pending = static_cast<std::size_t>(reader.gcount());
+        read += pending;
+        if (pending == sizeof(buffer)) {
+            hasher.update(buffer, pending);
+            pending = 0;
+        }
+    }
+    if (reader.bad() || read != size) {
+        // the file was changed while it was read
+        return false;
+    }
+
+    const auto consumed = hasher.update(buffer, pending);
+    result              = hasher.finish(buffer + consumed, pending - consumed);
+    return true;
+}
+
+std::string hash::toHex(std::uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string       result(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        result[static_cast<std::size_t>(i)] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return result;
+}
@@ -0,0 +1,54 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <boost/utility/string_view.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace docmala {
+namespace hash {
+
+/**
+ * @brief 64 bit non-cryptographic content hash (MurmurHash64A). Stable across runs and platforms
+ *        of the same endianness, so it may be persisted.
+ */
+DOCMALA_API std::uint64_t compute(const void* data, std::size_t size, std::uint64_t seed = 0);
+
+inline std::uint64_t compute(boost::string_view data, std::uint64_t seed = 0) {
+    return compute(data.data(), data.size(), seed);
+}
+
+/**
+ * @brief Hashes the content of a regular file, which is read in chunks. The result equals compute() over the content.
+ * @return false, if the file could not be read or changed while it was read
+ */
+DOCMALA_API bool computeForFile(const std::string& fileName, std::uint64_t& result);
+
+/**
+ * @brief Returns the hash as 16 hexadecimal digits.
+ */
+DOCMALA_API std::string toHex(std::uint64_t hash);
+
+} // namespace hash
+} // namespace docmala
@@ -0,0 +1,133 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Scanner.h"
+#include "CpuFeatures.h"
+
+#include <cassert>
+
+#ifdef DOCMALA_CPU_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace docmala;
+using namespace docmala::scanner;
+
+scanner::CharacterSet::CharacterSet(boost::string_view characters) {
+    for (char c : characters) {
+        add(c);
+    }
+}
+
+void scanner::CharacterSet::add(char c) {
+    assert(size < maxSize);
+    characters[size] = c;
+    size++;
+}
+
+namespace {
+using FindFirstOfFunction = const char* (*)(const char*, const char*, const CharacterSet&);
+
+const char* findFirstOfScalar(const char* begin, const char* end, const CharacterSet& characters) {
+    for (; begin < end; begin++) {
+        for (size_t i = 0; i < characters.size; i++) {
+            if (*begin == characters.characters[i]) {
+                return begin;
+            }
+        }
+    }
+    return end;
+}
+
+#ifdef DOCMALA_CPU_X86
+unsigned int countTrailingZeros(unsigned int mask) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+const char* findFirstOfSse2(const char* begin, const char* end, const CharacterSet& characters) {
+    __m128i needles[CharacterSet::maxSize];
+    for (size_t i = 0; i < characters.size; i++) {
+        needles[i] = _mm_set1_epi8(characters.characters[i]);
+    }
+
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i block   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i       matches = _mm_setzero_si128();
+        for (size_t i = 0; i < characters.size; i++) {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, needles[i]));
+        }
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(matches));
+        if (mask != 0) {
+            return begin + countTrailingZeros(mask);
+        }
+    }
+    return findFirstOfScalar(begin, end, characters);
+}
+
+#if !defined(_MSC_VER)
+__attribute__((target("avx2")))
+#endif
+const char*
+findFirstOfAvx2(const char* begin, const char* end, const CharacterSet& characters) {
+    __m256i needles[CharacterSet::maxSize];
+    for (size_t i = 0; i < characters.size; i++) {
+        needles[i] = _mm256_set1_epi8(characters.characters[i]);
+    }
+
+    for (; end - begin >= 32; begin += 32) {
+        const __m256i block   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i       matches = _mm256_setzero_si256();
+        for (size_t i = 0; i < characters.size; i++) {
+            matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, needles[i]));
+        }
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(matches));
+        if (mask != 0) {
+            return begin + countTrailingZeros(mask);
+        }
+    }
+    return findFirstOfSse2(begin, end, characters);
+}
+#endif
+
+FindFirstOfFunction selectFindFirstOf() {
+#ifdef DOCMALA_CPU_X86
+    if (cpu::supportsAvx2()) {
+        return findFirstOfAvx2;
+    }
+    return findFirstOfSse2;
+#else
+    return findFirstOfScalar;
+#endif
+}
+} // namespace
+
+const char* scanner::findFirstOf(const char* begin, const char* end, const CharacterSet& characters) {
+    static const FindFirstOfFunction implementation = selectFindFirstOf();
+    return implementation(begin, end, characters);
+}
@@ -0,0 +1,50 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <boost/utility/string_view.hpp>
+#include <cstddef>
+
+namespace docmala {
+namespace scanner {
+
+/**
+ * @brief A small set of characters (at most CharacterSet::maxSize) to search for.
+ */
+struct DOCMALA_API CharacterSet {
+    static constexpr size_t maxSize = 16;
+
+    CharacterSet(boost::string_view characters);
+    void add(char c);
+
+    char   characters[maxSize] = {0};
+    size_t size                = 0;
+};
+
+/**
+ * @brief Returns the first position in [begin, end), that contains one of the given characters, or end.
+ *        A vectorized implementation (AVX2, SSE2 or scalar) is selected at runtime.
+ */
+DOCMALA_API const char* findFirstOf(const char* begin, const char* end, const CharacterSet& characters);
+
+} // namespace scanner
+} // namespace docmala
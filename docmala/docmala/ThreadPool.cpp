@@ -0,0 +1,79 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace docmala;
+
+ThreadPool::ThreadPool(unsigned workerCount) {
+    if (workerCount == 0) {
+        workerCount = hardwareConcurrency();
+    }
+
+    _workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; i++) {
+        _workers.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeUp.notify_all();
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::hardwareConcurrency() {
+    // hardware_concurrency may return 0, if the value is not computable
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _wakeUp.notify_one();
+}
+
+void ThreadPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeUp.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+            if (_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,79 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "docmala_global.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace docmala {
+
+/**
+ * @brief A fixed number of worker threads, that execute submitted tasks in submission order.
+ *
+ * The destructor finishes all pending tasks before the workers are joined.
+ */
+class DOCMALA_API ThreadPool {
+public:
+    /**
+     * @brief Starts workerCount threads, the number of hardware threads if 0 is given.
+     */
+    explicit ThreadPool(unsigned workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues function for execution, the returned future provides its result or exception.
+     */
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task    = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        auto result  = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    unsigned workerCount() const {
+        return static_cast<unsigned>(_workers.size());
+    }
+
+    static unsigned hardwareConcurrency();
+
+private:
+    void enqueue(std::function<void()> task);
+    void run();
+
+    std::vector<std::thread>          _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex                        _mutex;
+    std::condition_variable           _wakeUp;
+    bool                              _stopping = false;
+};
+} // namespace docmala
@@ -18,21 +18,191 @@
         You should have received a copy of the GNU Lesser General Public License
         along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
+#include <docmala/BuildCache.h>
 #include <docmala/Docmala.h>
+#include <docmala/FileWatcher.h>
+#include <docmala/ThreadPool.h>
 
 using namespace std;
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+namespace {
+
+struct Result {
+    string      messages;
+    bool        outputCreated = true;
+    set<string> dependencies;
+};
+
+/**
+ * @brief Hands out one parser per worker thread, so plugins are loaded (and started) only once per worker.
+ */
+class ParserPool {
+public:
+    unique_ptr<docmala::Docmala> acquire() {
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (!_parsers.empty()) {
+                auto parser = std::move(_parsers.back());
+                _parsers.pop_back();
+                return parser;
+            }
+        }
+        auto parser = make_unique<docmala::Docmala>();
+        parser->useArena(true);
+        return parser;
+    }
+
+    void release(unique_ptr<docmala::Docmala> parser) {
+        lock_guard<mutex> lock(_mutex);
+        _parsers.push_back(std::move(parser));
+    }
+
+private:
+    mutex                                _mutex;
+    vector<unique_ptr<docmala::Docmala>> _parsers;
+};
+
+/**
+ * @brief Everything besides the content of the inputs, that has an influence on the generated output.
+ */
+string buildConfiguration(const docmala::Docmala& docmala, const docmala::ParameterList& parameters, const vector<string>& outputPlugins) {
+    ostringstream configuration;
+    for (const auto& parameter : parameters) {
+        configuration << "parameter " << parameter.first << "=" << parameter.second.value << "\n";
+    }
+    for (const auto& plugin : outputPlugins) {
+        configuration << "output " << plugin << "\n";
+    }
+    for (const auto& version : docmala.pluginVersions()) {
+        configuration << "plugin " << version.first << " " << version.second << "\n";
+    }
+    return configuration.str();
+}
+
+Result processDocument(docmala::Docmala&          docmala,
+                       const string&              inputFile,
+                       string                     outputDir,
+                       docmala::ParameterList     parameters,
+                       const vector<string>&      outputPlugins,
+                       const docmala::BuildCache* cache) {
+    Result        result;
+    ostringstream messages;
+
+    if (outputDir.empty()) {
+        outputDir = inputFile.substr(0, inputFile.find_last_of("\\/"));
+    }
+
+    parameters.emplace(make_pair("outputdir", docmala::Parameter{"outputdir", outputDir, docmala::FileLocation()}));
+
+    string configuration;
+    if (cache != nullptr) {
+        configuration = buildConfiguration(docmala, parameters, outputPlugins);
+        if (cache->isUpToDate(inputFile, configuration, &result.dependencies)) {
+            return result;
+        }
+    }
+
+    docmala.setParameters(parameters);
+    docmala.parseFile(inputFile);
+    result.dependencies = docmala.document().dependencies();
+
+    for (const auto& error : docmala.errors()) {
+        messages << error.location.fileName() << "(" << error.location.line << ":" << error.location.column << "): " << error.message << "\n";
+    }
+
+    for (const auto& plugin : outputPlugins) {
+        if (!docmala.produceOutput(plugin)) {
+            messages << "Unable to create output for plugin: " << plugin << "\n";
+            result.outputCreated = false;
+            break;
+        }
+    }
+
+    if (cache != nullptr) {
+        // documents with errors are not recorded, so their errors are reported again by the next build
+        if (result.outputCreated && !outputPlugins.empty() && docmala.errors().empty()) {
+            cache->store(inputFile, configuration, docmala.document().dependencies(), docmala.document().dependencyHashes(), docmala.outputFiles());
+        } else {
+            cache->invalidate(inputFile);
+        }
+    }
+
+    result.messages = messages.str();
+    return result;
+}
+
+void addInputDirectory(const string& directory, vector<string>& inputFiles) {
+    vector<string> found;
+    for (fs::recursive_directory_iterator iter(directory), end; iter != end; ++iter) {
+        if (fs::is_regular_file(iter->status()) && iter->path().extension() == ".dml") {
+            found.push_back(iter->path().string());
+        }
+    }
+    // directory iteration order is unspecified
+    sort(found.begin(), found.end());
+    inputFiles.insert(inputFiles.end(), found.begin(), found.end());
+}
+
+bool addManifest(const string& manifest, vector<string>& inputFiles) {
+    ifstream reader(manifest);
+    if (!reader) {
+        return false;
+    }
+
+    string line;
+    while (getline(reader, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line.front() != ';') {
+            inputFiles.push_back(line);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Removes inputs, that are given more than once (e.g. by --input and --inputdir), so no document is built
+ *        twice or by two jobs at the same time. The first occurrence is kept with its spelling.
+ */
+void removeDuplicateInputs(vector<string>& inputFiles) {
+    set<string>    seen;
+    vector<string> unique;
+    for (auto& inputFile : inputFiles) {
+        boost::system::error_code error;
+        auto                      path = fs::weakly_canonical(inputFile, error);
+        if (seen.insert(error ? inputFile : path.string()).second) {
+            unique.push_back(std::move(inputFile));
+        }
+    }
+    inputFiles.swap(unique);
+}
+} // namespace
 
 int main(int argc, char* argv[]) {
     po::options_description desc("Documentation Markup Language");
     desc.add_options()("help", "produce this help message") //
-        ("input,i", po::value<string>(), "input file") //
+        ("input,i", po::value<vector<string>>()->composing(), "input file, can be given multiple times") //
+        ("inputdir,d", po::value<vector<string>>()->composing(), "process all .dml files in this directory and its subdirectories") //
+        ("manifest,m", po::value<vector<string>>()->composing(), "file listing one input file per line") //
+        ("cache,c", po::value<string>(), "directory of the incremental build cache, documents whose inputs did not change are skipped") //
+        ("watch,w", "keep running and update documents, when they or the files they depend on change") //
+        ("jobs,j", po::value<unsigned>(), "number of documents processed in parallel, defaults to the number of hardware threads") //
         ("outputdir,o", po::value<string>(), "output directory") //
         ("outputplugins,p", po::value<vector<string>>(), "plugins for output generation") //
         ("parameters",
@@ -48,30 +218,52 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    docmala::Docmala       docmala;
     docmala::ParameterList parameters;
 
     if (vm.count("listoutputplugins") != 0u) {
+        docmala::Docmala docmala;
         for (const auto& plugin : docmala.listOutputPlugins()) {
             cout << plugin << "\n";
 }
         return 0;
     }
 
-    string outputDir;
-    string inputFile;
+    string         outputDir;
+    vector<string> inputFiles;
 
     if (vm.count("input") != 0u) {
-        inputFile = vm["input"].as<string>();
-    } else {
+        inputFiles = vm["input"].as<vector<string>>();
+    }
+
+    if (vm.count("inputdir") != 0u) {
+        for (const auto& directory : vm["inputdir"].as<vector<string>>()) {
+            try {
+                addInputDirectory(directory, inputFiles);
+            } catch (const fs::filesystem_error& e) {
+                cout << "Unable to read input directory '" << directory << "': " << e.what() << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (vm.count("manifest") != 0u) {
+        for (const auto& manifest : vm["manifest"].as<vector<string>>()) {
+            if (!addManifest(manifest, inputFiles)) {
+                cout << "Unable to read manifest '" << manifest << "'\n";
+                return 1;
+            }
+        }
+    }
+
+    removeDuplicateInputs(inputFiles);
+
+    if (inputFiles.empty()) {
         cout << "An input file has to be specified\n";
         return 1;
     }
 
     if (vm.count("outputdir") != 0u) {
         outputDir = vm["outputdir"].as<string>();
-    } else {
-        outputDir = inputFile.substr(0, inputFile.find_last_of("\\/"));
     }
 
     if (vm.count("parameters") != 0u) {
@@ -87,25 +279,101 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    parameters.emplace(make_pair("outputdir", docmala::Parameter{"outputdir", outputDir, docmala::FileLocation()}));
-    docmala.setParameters(parameters);
-    docmala.parseFile(inputFile);
+    vector<string> outputPlugins;
+    if (vm.count("outputplugins") != 0u) {
+        outputPlugins = vm["outputplugins"].as<vector<string>>();
+    }
 
-    for (const auto& error : docmala.errors()) {
-        cout << error.location.fileName << "(" << error.location.line << ":" << error.location.column << "): " << error.message << "\n";
+    unsigned jobs = vm.count("jobs") != 0u ? vm["jobs"].as<unsigned>() : docmala::ThreadPool::hardwareConcurrency();
+    jobs          = max(1u, min(jobs, static_cast<unsigned>(inputFiles.size())));
+
+    unique_ptr<docmala::BuildCache> cache;
+    if (vm.count("cache") != 0u) {
+        cache = make_unique<docmala::BuildCache>(vm["cache"].as<string>());
     }
 
-    if (vm.count("outputplugins") != 0u) {
-        for (const auto& plugin : vm["outputplugins"].as<vector<string>>()) {
-            if (!docmala.produceOutput(plugin)) {
-                cout << "Unable to create output for plugin: " << plugin << "\n";
-                return -1;
-            }
+    ParserPool               parsers;
+    docmala::ThreadPool      pool(jobs);
+    map<string, set<string>> dependencies;
+
+    // builds the given documents, returns false if an output could not be created
+    auto build = [&](const vector<string>& documents) {
+        vector<future<Result>> results;
+        for (const auto& inputFile : documents) {
+            results.push_back(pool.submit([&, inputFile]() {
+                auto parser = parsers.acquire();
+                auto result = processDocument(*parser, inputFile, outputDir, parameters, outputPlugins, cache.get());
+                parsers.release(std::move(parser));
+                return result;
+            }));
         }
-    } else {
+
+        // messages are reported in input order, independent of the order documents finish in
+        bool outputCreated = true;
+        for (size_t i = 0; i < documents.size(); i++) {
+            auto documentResult = results[i].get();
+            cout << documentResult.messages << flush;
+            outputCreated              = outputCreated && documentResult.outputCreated;
+            dependencies[documents[i]] = std::move(documentResult.dependencies);
+        }
+        return outputCreated;
+    };
+
+    const bool outputCreated = build(inputFiles);
+
+    if (outputPlugins.empty()) {
         cout << "No output plugin specified. No output is generated.\n";
         return -1;
     }
 
+    if (vm.count("watch") != 0u) {
+        docmala::FileWatcher watcher;
+        if (!watcher.isSupported()) {
+            cout << "Watching files is not supported on this platform\n";
+            return -1;
+        }
+
+        auto watchDependencies = [&]() {
+            for (const auto& document : dependencies) {
+                watcher.watch(document.first);
+                for (const auto& file : document.second) {
+                    watcher.watch(file);
+                }
+            }
+        };
+
+        watchDependencies();
+        cout << "Watching for changes, press Ctrl+C to stop.\n" << flush;
+
+        while (true) {
+            const auto changes = watcher.waitForChanges(chrono::milliseconds(20));
+
+            vector<string> changedDocuments;
+            for (const auto& inputFile : inputFiles) {
+                const auto& files = dependencies[inputFile];
+                if (changes.count(inputFile) != 0u
+                    || any_of(files.begin(), files.end(), [&changes](const string& file) { return changes.count(file) != 0u; })) {
+                    changedDocuments.push_back(inputFile);
+                }
+            }
+
+            if (changedDocuments.empty()) {
+                continue;
+            }
+
+            const auto start = chrono::steady_clock::now();
+            build(changedDocuments);
+            const auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+            cout << "Updated " << changedDocuments.size() << " document(s) in " << duration.count() << " ms\n" << flush;
+
+            // included files may have been added
+            watchDependencies();
+        }
+    }
+
+    if (!outputCreated) {
+        return -1;
+    }
+
     return 0;
 }
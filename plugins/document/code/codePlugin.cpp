@@ -49,7 +49,7 @@ std::vector<Error> CodePlugin::process(const ParameterList& parameters, const Fi
     }
 
     code.code = block;
-    document.addPart(code);
+    document.addPart(std::move(code));
 
     return {};
 }
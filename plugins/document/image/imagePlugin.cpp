@@ -20,9 +20,9 @@
  */
 #include <docmala/DocmaPlugin.h>
 #include <docmala/Error.h>
+#include <docmala/Hash.h>
 #include <extension_system/Extension.hpp>
 #include <fstream>
-#include <unordered_map>
 
 using namespace docmala;
 
@@ -30,15 +30,19 @@ class ImagePlugin : public DocumentPlugin {
     // DocmaPlugin interface
 public:
     BlockProcessing blockProcessing() const override;
+    Execution       execution() const override;
     std::vector<Error> process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) override;
-
-    std::unordered_map<std::string, document_part::Image> _cache;
 };
 
 DocumentPlugin::BlockProcessing ImagePlugin::blockProcessing() const {
     return BlockProcessing::No;
 }
 
+DocumentPlugin::Execution ImagePlugin::execution() const {
+    // reading the image file does not depend on the rest of the document
+    return Execution::Deferred;
+}
+
 std::vector<Error> ImagePlugin::process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) {
     (void)block;
 
@@ -74,16 +78,18 @@ std::vector<Error> ImagePlugin::process(const ParameterList& parameters, const F
         return errors;
     }
 
-    std::string imageData;
+    document_part::String imageData;
 
     std::ifstream highlightReader(fileName, std::ios::in | std::ios::binary);
     if (highlightReader) {
         highlightReader.seekg(0, std::ios::end);
-        imageData.resize(static_cast<std::string::size_type>(highlightReader.tellg()));
+        imageData.resize(static_cast<document_part::String::size_type>(highlightReader.tellg()));
         highlightReader.seekg(0, std::ios::beg);
         highlightReader.read(&imageData[0], static_cast<std::streamsize>(imageData.size()));
         highlightReader.close();
+        document.addDependency(fileName, hash::compute(imageData));
     } else {
+        document.addDependency(fileName);
         errors.emplace_back(location, "Unable to open file '" + fileName + "'.");
     }
 
@@ -97,9 +103,8 @@ std::vector<Error> ImagePlugin::process(const ParameterList& parameters, const F
 
     document_part::Text text;
     text.text.emplace_back(fileName);
-    document_part::Image image(format, fileExtension, imageData, text);
-    _cache.insert(std::make_pair(block, image));
-    document.addPart(image);
+    document_part::Image image(format, fileExtension, std::move(imageData), std::move(text));
+    document.addPart(std::move(image));
 
     return errors;
 }
@@ -19,17 +19,301 @@
         along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <algorithm>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdint>
 #include <docmala/DocmaPlugin.h>
 #include <docmala/Docmala.h>
+#include <docmala/Hash.h>
 #include <extension_system/Extension.hpp>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sys/stat.h>
 
 using namespace docmala;
 
+namespace {
+
+/**
+ * @brief Modification time and size of a file, a file with an unchanged stamp is not hashed again.
+ */
+struct FileStamp {
+    std::int64_t  modified            = 0;
+    long          modifiedNanoseconds = 0;
+    std::uint64_t size                = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return modified == other.modified && modifiedNanoseconds == other.modifiedNanoseconds && size == other.size;
+    }
+};
+
+/**
+ * @return false, if the file does not exist
+ */
+bool fileStamp(const std::string& fileName, FileStamp& stamp) {
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0) {
+        return false;
+    }
+    stamp.modified = static_cast<std::int64_t>(info.st_mtime);
+    stamp.size     = static_cast<std::uint64_t>(info.st_size);
+#if defined(__APPLE__)
+    stamp.modifiedNanoseconds = info.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+    stamp.modifiedNanoseconds = info.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+/**
+ * @brief Result of parsing an included file, shared by all documents including it.
+ */
+struct ParsedInclude {
+    Document                             document;          ///< its parts are shared by the GeneratedDocuments of the includes
+    std::vector<Error>                   errors;
+    std::set<std::string>                dependencies;
+    std::map<std::string, std::uint64_t> dependencyHashes;  ///< as read while parsing, missing files have none
+    std::map<std::string, FileStamp>     verifiedStamps;    ///< stamps of the dependencies, whose hash was verified
+    std::set<std::string>                dependencyPaths;   ///< canonical paths of the dependencies
+    std::string                          includeChain;      ///< include chain of the document, that included the file
+    bool                                 recursive = false; ///< a nested include was recursive, the result depends on includeChain
+};
+
+/**
+ * @brief Stamps the dependencies of include, that still have the content read while parsing.
+ *        The stamp is taken before the content is hashed, so a later change always changes the stamp.
+ */
+void verifyDependencies(ParsedInclude& include) {
+    for (const auto& dependency : include.dependencyHashes) {
+        FileStamp     stamp;
+        std::uint64_t contentHash = 0;
+        if (fileStamp(dependency.first, stamp) && hash::computeForFile(dependency.first, contentHash) && contentHash == dependency.second) {
+            include.verifiedStamps[dependency.first] = stamp;
+        }
+    }
+}
+
+/**
+ * @brief Process wide cache of parsed includes, keyed by the canonical path of the included file.
+ *
+ * An entry is used as long as the content of the included file and of everything it depends on
+ * (nested includes, images, ...) is unchanged. Only dependencies with a changed modification time or size
+ * are hashed again. A file, that is requested while it is being parsed, is not parsed a second time,
+ * the request waits for the running parse instead. Nested includes do not wait, with cyclic includes
+ * two parses could wait for each other. Parses, that hit a recursive include, are not kept.
+ */
+class ParsedIncludeCache {
+public:
+    using Entry = std::shared_ptr<const ParsedInclude>;
+
+    Entry get(const std::string& key, const std::function<Entry()>& parse, bool waitForRunningParse) {
+        std::shared_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto                        iter = _slots.find(key);
+            if (iter != _slots.end()) {
+                slot = iter->second;
+            }
+        }
+
+        if (slot && !waitForRunningParse && slot->entry.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return parse();
+        }
+
+        if (slot) {
+            auto entry = slot->entry.get();
+            if (isUpToDate(*entry)) {
+                return entry;
+            }
+        }
+
+        std::shared_ptr<Slot> running;
+        auto                  newSlot = std::make_shared<Slot>();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto&                       current = _slots[key];
+            if (current != slot) {
+                // another thread started parsing the file in the meantime
+                running = current;
+            } else {
+                current = newSlot;
+            }
+        }
+
+        if (running) {
+            if (!waitForRunningParse && running->entry.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return parse();
+            }
+            return running->entry.get();
+        }
+
+        try {
+            auto entry = parse();
+            newSlot->result.set_value(entry);
+            if (entry->recursive) {
+                // only valid for the include chain it was parsed with
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_slots[key] == newSlot) {
+                    _slots.erase(key);
+                }
+            }
+            return entry;
+        } catch (...) {
+            newSlot->result.set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_slots[key] == newSlot) {
+                _slots.erase(key);
+            }
+            throw;
+        }
+    }
+
+private:
+    struct Slot {
+        std::promise<Entry>       result;
+        std::shared_future<Entry> entry = result.get_future().share();
+    };
+
+    static bool isUpToDate(const ParsedInclude& include) {
+        for (const auto& dependency : include.dependencies) {
+            FileStamp  stamp;
+            const bool exists   = fileStamp(dependency, stamp);
+            const auto verified = include.verifiedStamps.find(dependency);
+            if (verified != include.verifiedStamps.end() && exists && verified->second == stamp) {
+                continue;
+            }
+
+            std::uint64_t contentHash = 0;
+            const bool    read        = hash::computeForFile(dependency, contentHash);
+            const auto    recorded    = include.dependencyHashes.find(dependency);
+            // a file, that was missing while parsing, must still be missing
+            const bool unchanged = recorded == include.dependencyHashes.end() ? !read : read && recorded->second == contentHash;
+            if (!unchanged) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::mutex                                   _mutex;
+    std::map<std::string, std::shared_ptr<Slot>> _slots;
+};
+
+ParsedIncludeCache& parsedIncludes() {
+    static ParsedIncludeCache cache;
+    return cache;
+}
+
+std::string canonicalPath(const std::string& fileName) {
+    boost::system::error_code error;
+    auto                      path = boost::filesystem::weakly_canonical(fileName, error);
+    return error ? fileName : path.string();
+}
+
+/**
+ * @brief Canonical paths of the files including the parsed one, one per line. It is passed to the parsers of
+ *        included files as parameter, because their includes may be processed by any thread.
+ */
+const char* const includeChainParameter = "includeChain";
+
+bool isOnIncludeChain(const std::string& includeChain, const std::string& path) {
+    std::size_t begin = 0;
+    while (begin <= includeChain.size()) {
+        auto end = includeChain.find('\n', begin);
+        if (end == std::string::npos) {
+            end = includeChain.size();
+        }
+        if (includeChain.compare(begin, end - begin, path) == 0) {
+            return true;
+        }
+        begin = end + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Include chains of the parses, that hit a recursive include, one canonical path per line.
+ *        Their result depends on the chain, so it must not be shared with other documents.
+ */
+class RecursiveChains {
+public:
+    /**
+     * @brief Records, that a file including path was parsed with includeChain.
+     *        Every parse of the chain below the first include of path is affected.
+     */
+    void add(const std::string& includeChain, const std::string& path) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bool                        affected = false;
+        std::size_t                 begin    = 0;
+        while (begin <= includeChain.size()) {
+            auto end = includeChain.find('\n', begin);
+            if (end == std::string::npos) {
+                end = includeChain.size();
+            }
+            if (affected) {
+                _chains.insert(includeChain.substr(0, end));
+            } else {
+                affected = includeChain.compare(begin, end - begin, path) == 0;
+            }
+            begin = end + 1;
+        }
+    }
+
+    bool contains(const std::string& chain) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _chains.count(chain) != 0u;
+    }
+
+private:
+    std::mutex            _mutex;
+    std::set<std::string> _chains;
+};
+
+RecursiveChains& recursiveChains() {
+    static RecursiveChains chains;
+    return chains;
+}
+
+/**
+ * @return true, if include was parsed with includeChain or its result does not depend on the chain
+ */
+bool isValidFor(const ParsedInclude& include, const std::string& includeChain) {
+    if (include.includeChain == includeChain) {
+        return true;
+    }
+    if (include.recursive) {
+        return false;
+    }
+    // a file of the chain would be a recursive include for this document
+    return std::none_of(include.dependencyPaths.begin(), include.dependencyPaths.end(), [&](const std::string& path) {
+        return isOnIncludeChain(includeChain, path);
+    });
+}
+
+/**
+ * @brief Parameters of the including document, which are passed on to the parser of the included file.
+ *        The parameters of the include block itself are left out.
+ */
+ParameterList forwardedParameters(const ParameterList& parameters) {
+    ParameterList forwarded;
+    for (const auto& parameter : parameters) {
+        if (parameter.first != "file" && parameter.first != "as" && parameter.first != "inputFile" && parameter.first != "pluginDir"
+            && parameter.first != includeChainParameter) {
+            forwarded.insert(parameter);
+        }
+    }
+    return forwarded;
+}
+} // namespace
+
 class IncludePlugin : public DocumentPlugin {
     // DocmaPlugin interface
 public:
     BlockProcessing blockProcessing() const override;
+    Execution       execution() const override;
     std::vector<Error> process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) override;
 
     PostProcessing     postProcessing() const override;
@@ -39,50 +323,40 @@ public:
         std::replace(fileName.begin(), fileName.end(), '.', '_');
     }
 
-    std::unique_ptr<Docmala> parser;
+    std::unique_ptr<Docmala> acquireParser(const std::string& pluginDir);
+    void                     releaseParser(std::unique_ptr<Docmala> parser);
 
-    void updateDocumentParts(const std::string&                        identifier,
-                             document_part::GeneratedDocument&          out,
-                             const std::vector<document_part::Variant>& parts,
-                             bool                                      keepHeadlineLevel,
-                             int                                       baseLevel);
-    void postProcessParts(const std::string& identifier, std::vector<document_part::Variant>& parts);
+    void postProcessParts(const std::string& identifier, document_part::PartList& parts);
+    bool linksTo(const std::string& identifier, const document_part::PartList& parts);
+
+    // included files are parsed concurrently, every parse needs a parser of its own
+    std::mutex                            _parsersMutex;
+    std::vector<std::unique_ptr<Docmala>> _parsers;
 };
 
 DocumentPlugin::BlockProcessing IncludePlugin::blockProcessing() const {
     return BlockProcessing::No;
 }
 
-void IncludePlugin::updateDocumentParts(const std::string&                        identifier,
-                                        document_part::GeneratedDocument&          out,
-                                        const std::vector<document_part::Variant>& parts,
-                                        bool                                      keepHeadlineLevel,
-                                        int                                       baseLevel) {
-    int  currentLevel = 0;
-    auto visitor      = make_visitor(
-        // visitors
-        [&](document_part::Headline& headline) {
-            if (!keepHeadlineLevel) {
-                headline.level += baseLevel;
-                out.document.emplace_back(headline);
-                currentLevel = headline.level;
-            }
-        },
-        [&](document_part::Anchor& anchor) {
-            anchor.name = identifier + ":" + anchor.name;
-            out.document.emplace_back(anchor);
-
-        },
-        [&](const document_part::GeneratedDocument& doc) {
-            document_part::GeneratedDocument outDoc(doc.location);
-            updateDocumentParts(identifier, outDoc, doc.document, keepHeadlineLevel, currentLevel);
-            out.document.emplace_back(outDoc);
-        },
-        [&](const auto& part) { out.document.push_back(part); });
+DocumentPlugin::Execution IncludePlugin::execution() const {
+    return Execution::Deferred;
+}
 
-    for (auto& part : parts) {
-        boost::apply_visitor(visitor, part);
+std::unique_ptr<Docmala> IncludePlugin::acquireParser(const std::string& pluginDir) {
+    {
+        std::lock_guard<std::mutex> lock(_parsersMutex);
+        if (!_parsers.empty()) {
+            auto parser = std::move(_parsers.back());
+            _parsers.pop_back();
+            return parser;
+        }
     }
+    return std::make_unique<Docmala>(pluginDir);
+}
+
+void IncludePlugin::releaseParser(std::unique_ptr<Docmala> parser) {
+    std::lock_guard<std::mutex> lock(_parsersMutex);
+    _parsers.push_back(std::move(parser));
 }
 
 std::vector<Error>
@@ -92,12 +366,15 @@ IncludePlugin::process(const ParameterList& parameters, const FileLocation& loca
     std::string pluginDir     = "./plugins";
     auto        pluginDirIter = parameters.find("pluginDir");
     if (pluginDirIter != parameters.end()) {
-        pluginDir = pluginDirIter->second.value + '/';
+        pluginDir = pluginDirIter->second.value;
+    }
+    // the cache key must be the same for the parsers of nested includes
+    while (pluginDir.size() > 1 && (pluginDir.back() == '/' || pluginDir.back() == '\\')) {
+        pluginDir.pop_back();
     }
 
     std::string includeFile;
     std::string inputFile;
-    bool        keepHeadlineLevel = false;
 
     auto inFileIter = parameters.find("inputFile");
     if (inFileIter != parameters.end()) {
@@ -116,42 +393,77 @@ IncludePlugin::process(const ParameterList& parameters, const FileLocation& loca
         return {{location, "Parameter 'file' is missing."}};
     }
 
-    std::string identifier     = includeFile;
-    auto        identifierIter = parameters.find("as");
+    const auto fileName = baseDir + "/" + includeFile;
+    const auto path     = canonicalPath(fileName);
 
-    if (identifierIter != parameters.end()) {
-        identifier = identifierIter->second.value;
+    std::string parentChain;
+    auto        chainIter = parameters.find(includeChainParameter);
+    if (chainIter != parameters.end()) {
+        parentChain = chainIter->second.value;
     }
+    const auto includeChain = parentChain.empty() ? canonicalPath(inputFile) : parentChain + "\n" + canonicalPath(inputFile);
 
-    if (parameters.find("keepHeadlineLevel") != parameters.end()) {
-        keepHeadlineLevel = true;
+    if (isOnIncludeChain(includeChain, path)) {
+        recursiveChains().add(includeChain, path);
+        return {{location, "Recursive include of file '" + fileName + "'."}};
     }
 
-    if (!parser) {
-        parser = std::make_unique<Docmala>(pluginDir);
+    auto parameterList = forwardedParameters(parameters);
+    // the result depends on the parameters, e.g. the output directory of generated images
+    auto cacheKey = pluginDir + "\n" + path;
+    for (const auto& parameter : parameterList) {
+        cacheKey += "\n" + parameter.first + "=" + parameter.second.value;
+    }
+    parameterList[includeChainParameter] = Parameter{includeChainParameter, includeChain, FileLocation()};
+
+    const auto parse = [&]() {
+        auto parser = acquireParser(pluginDir);
+        parser->setParameters(parameterList);
+        parser->parseFile(fileName);
+
+        // the entry outlives the including document, so it must not use its arena
+        Arena::Scope heap(nullptr);
+
+        auto result    = std::make_shared<ParsedInclude>();
+        result->errors = parser->takeErrors();
+        auto doc       = parser->takeDocument();
+        releaseParser(std::move(parser));
+
+        result->dependencies     = doc.dependencies();
+        result->dependencyHashes = doc.dependencyHashes();
+        result->document         = std::move(doc);
+        for (const auto& dependency : result->dependencies) {
+            result->dependencyPaths.insert(canonicalPath(dependency));
+        }
+        result->includeChain = includeChain;
+        result->recursive    = recursiveChains().contains(includeChain + "\n" + path);
+        verifyDependencies(*result);
+        return ParsedIncludeCache::Entry(std::move(result));
+    };
+
+    const bool nested = !parentChain.empty();
+    auto       parsed = parsedIncludes().get(cacheKey, parse, !nested);
+    if (!isValidFor(*parsed, includeChain)) {
+        parsed = parse();
     }
 
-    parser->parseFile(baseDir + "/" + includeFile);
-
-    auto                            errors    = parser->errors();
-    auto                            doc       = parser->document();
-    int                             baseLevel = 1;
-    document_part::GeneratedDocument generated(location);
-
-    if (!keepHeadlineLevel) {
-        for (auto iter = document.parts().rbegin(); iter != document.parts().rend(); iter++) {
-            auto headline = boost::get<document_part::Headline>(&(*iter));
-            if (headline) {
-                baseLevel = headline->level;
-                break;
-            }
+    for (const auto& dependency : parsed->dependencies) {
+        const auto contentHash = parsed->dependencyHashes.find(dependency);
+        if (contentHash != parsed->dependencyHashes.end()) {
+            document.addDependency(dependency, contentHash->second);
+        } else {
+            document.addDependency(dependency);
         }
     }
 
-    updateDocumentParts(identifier, generated, doc.parts(), keepHeadlineLevel, baseLevel);
+    // the parts are shared with all includes of the file, postProcess copies them, if it rewrites links
+    document_part::GeneratedDocument generated(location);
+    generated.shared = &parsed->document.parts();
 
-    document.addPart(generated);
+    document.keepAlive(parsed);
+    document.addPart(std::move(generated));
 
+    auto errors = parsed->errors;
     return errors;
 }
 
@@ -159,7 +471,7 @@ DocumentPlugin::PostProcessing IncludePlugin::postProcessing() const {
     return PostProcessing::Once;
 }
 
-void IncludePlugin::postProcessParts(const std::string& identifier, std::vector<document_part::Variant>& parts) {
+void IncludePlugin::postProcessParts(const std::string& identifier, document_part::PartList& parts) {
 
     auto visitor = make_visitor(
         // visitors
@@ -171,7 +483,17 @@ void IncludePlugin::postProcessParts(const std::string& identifier, std::vector<
                 }
             }
         },
-        [&](document_part::GeneratedDocument& doc) { postProcessParts(identifier, doc.document); },
+        [&](document_part::GeneratedDocument& doc) {
+            if (doc.shared != nullptr) {
+                if (!linksTo(identifier, *doc.shared)) {
+                    return;
+                }
+                // the shared parts stay untouched, the links of a copy are rewritten
+                doc.document = *doc.shared;
+                doc.shared   = nullptr;
+            }
+            postProcessParts(identifier, doc.document);
+        },
         [&](document_part::Text& text) { postProcessParts(identifier, text.text); },
         [&](const document_part::Table& table) {
             for (auto row : table.cells) {
@@ -187,6 +509,36 @@ void IncludePlugin::postProcessParts(const std::string& identifier, std::vector<
     }
 }
 
+bool IncludePlugin::linksTo(const std::string& identifier, const document_part::PartList& parts) {
+    bool found   = false;
+    auto visitor = make_visitor(
+        // visitors
+        [&](const document_part::Link& link) {
+            if (link.type == document_part::Link::Type::InterFile) {
+                std::string fileName = link.data.substr(0, link.data.find(':'));
+                found                = fileName == identifier;
+            }
+        },
+        [&](const document_part::GeneratedDocument& doc) { found = linksTo(identifier, doc.parts()); },
+        [&](const document_part::Text& text) { found = linksTo(identifier, text.text); },
+        [&](const document_part::Table& table) {
+            for (const auto& row : table.cells) {
+                for (const auto& cell : row) {
+                    found = found || linksTo(identifier, cell.content);
+                }
+            }
+        },
+        [](const auto&) {});
+
+    for (const auto& part : parts) {
+        boost::apply_visitor(visitor, part);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::vector<Error> IncludePlugin::postProcess(const ParameterList& parameters, const FileLocation& location, Document& document) {
     std::string includeFile;
     std::string inputFile;
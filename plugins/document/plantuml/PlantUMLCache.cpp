@@ -0,0 +1,166 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PlantUMLCache.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <docmala/Hash.h>
+#include <fstream>
+#include <vector>
+
+using namespace docmala;
+namespace fs = boost::filesystem;
+
+namespace {
+const char* const entryExtension = ".svg";
+
+struct Entry {
+    fs::path      path;
+    std::time_t   lastUse = 0;
+    std::uint64_t size    = 0;
+};
+
+std::vector<Entry> listEntries(const std::string& directory) {
+    std::vector<Entry>        entries;
+    boost::system::error_code error;
+    for (fs::directory_iterator iter(directory, error), end; !error && iter != end; iter.increment(error)) {
+        if (iter->path().extension() != entryExtension) {
+            continue;
+        }
+        boost::system::error_code entryError;
+        Entry                     entry;
+        entry.path    = iter->path();
+        entry.size    = fs::file_size(entry.path, entryError);
+        entry.lastUse = fs::last_write_time(entry.path, entryError);
+        if (!entryError) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    return entries;
+}
+} // namespace
+
+PlantUMLCache::PlantUMLCache(std::string directory, std::uint64_t maximumSize, std::uint64_t version)
+    : _directory(std::move(directory))
+    , _maximumSize(maximumSize)
+    , _version(version) {
+    boost::system::error_code error;
+    fs::create_directories(_directory, error);
+}
+
+std::string PlantUMLCache::entryFileName(const std::string& source) const {
+    return _directory + "/" + hash::toHex(hash::compute(source, _version)) + entryExtension;
+}
+
+bool PlantUMLCache::load(const std::string& source, document_part::String& data) {
+    const auto    fileName = entryFileName(source);
+    std::ifstream reader(fileName, std::ios::in | std::ios::binary);
+    if (!reader) {
+        return false;
+    }
+
+    reader.seekg(0, std::ios::end);
+    const auto size = reader.tellg();
+    reader.seekg(0, std::ios::beg);
+    if (size <= 0) {
+        return false;
+    }
+
+    data.resize(static_cast<size_t>(size));
+    if (!reader.read(&data[0], size)) {
+        return false;
+    }
+
+    // the modification time is the time of last use, entries not used for the longest time are evicted first
+    boost::system::error_code error;
+    fs::last_write_time(fileName, std::time(nullptr), error);
+    return true;
+}
+
+void PlantUMLCache::store(const std::string& source, const document_part::String& data) {
+    const auto                fileName = entryFileName(source);
+    boost::system::error_code error;
+    const auto                temporaryFileName = fs::unique_path(fileName + ".%%%%-%%%%.tmp", error);
+    if (error) {
+        return;
+    }
+
+    {
+        std::ofstream writer(temporaryFileName.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!writer || !writer.write(data.data(), static_cast<std::streamsize>(data.size())).flush()) {
+            writer.close();
+            fs::remove(temporaryFileName, error);
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // an existing entry is replaced, its size must not be counted twice
+    boost::system::error_code sizeError;
+    std::uint64_t             replacedSize = fs::file_size(fileName, sizeError);
+    if (sizeError) {
+        replacedSize = 0;
+    }
+
+    fs::rename(temporaryFileName, fileName, error);
+    if (error) {
+        fs::remove(temporaryFileName, error);
+        return;
+    }
+
+    if (!_sizeKnown) {
+        // other runs may have added entries, so the size is taken from the directory once
+        for (const auto& entry : listEntries(_directory)) {
+            _size += entry.size;
+        }
+        _sizeKnown = true;
+    } else {
+        _size += data.size();
+        _size -= std::min(replacedSize, _size);
+    }
+
+    if (_size > _maximumSize) {
+        evict();
+    }
+}
+
+void PlantUMLCache::evict() {
+    auto entries = listEntries(_directory);
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+    _size = 0;
+    for (const auto& entry : entries) {
+        _size += entry.size;
+    }
+
+    // shrink below the limit with some headroom, so not every following store has to scan the directory
+    const auto                targetSize = _maximumSize - _maximumSize / 4;
+    boost::system::error_code error;
+    for (const auto& entry : entries) {
+        if (_size <= targetSize) {
+            break;
+        }
+        if (fs::remove(entry.path, error)) {
+            _size -= entry.size;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <docmala/DocumentPart.h>
+#include <mutex>
+#include <string>
+
+namespace docmala {
+
+/**
+ * @brief Persistent store of rendered diagrams, so unchanged diagrams are not rendered again by the next run.
+ *
+ * Every rendered diagram is kept as one file, named after the hash of the diagram source and the version of
+ * the renderer. Files are written to a temporary name first and renamed afterwards, so concurrent runs sharing
+ * the directory never see a partially written entry.
+ * Reading an entry updates its modification time. When the directory grows beyond maximumSize, the entries
+ * that were not used for the longest time are removed.
+ */
+class PlantUMLCache {
+public:
+    PlantUMLCache(std::string directory, std::uint64_t maximumSize, std::uint64_t version);
+
+    /**
+     * @brief Reads the rendered diagram of source into data.
+     * @return false, if no entry exists for source
+     */
+    bool load(const std::string& source, document_part::String& data);
+
+    /**
+     * @brief Stores the rendered diagram of source, failures are ignored, the entry is simply missing next time.
+     */
+    void store(const std::string& source, const document_part::String& data);
+
+private:
+    std::string entryFileName(const std::string& source) const;
+    void        evict();
+
+    std::string   _directory;
+    std::uint64_t _maximumSize = 0;
+    std::uint64_t _version     = 0;
+
+    std::mutex    _mutex;
+    bool          _sizeKnown = false;
+    std::uint64_t _size      = 0;
+};
+} // namespace docmala
@@ -20,13 +20,25 @@
  */
 #include "DetectOS.h"
 #ifdef CURRENT_OS_LINUX
+#include "PlantUMLCache.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <docmala/DocmaPlugin.h>
+#include <docmala/Hash.h>
+#include <docmala/ThreadPool.h>
 #include <extension_system/Extension.hpp>
 #include <fcntl.h>
 #include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <spawn.h>
 #include <sstream>
 #include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
 #include <unordered_map>
 
 using namespace docmala;
@@ -46,180 +58,533 @@ void split(const std::string& s, char c, std::vector<std::string>& v) {
         }
     }
 }
-} // namespace
 
-class PlantUMLPlugin : public DocumentPlugin {
-    // DocmaPlugin interface
-public:
-    ~PlantUMLPlugin() override;
+std::string pluginDirectory(const ParameterList& parameters) {
+    auto pluginDirIter = parameters.find("pluginDir");
+    if (pluginDirIter != parameters.end()) {
+        return pluginDirIter->second.value + '/';
+    }
+    return {};
+}
 
-    BlockProcessing blockProcessing() const override;
-    std::vector<Error> process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) override;
-    std::vector<Error> initHost(const ParameterList& parameters, const FileLocation& location);
+/**
+ * @brief Identifies the renderer, a different PlantUML version may render the same diagram differently.
+ */
+std::uint64_t rendererVersion(const std::string& pluginDir) {
+    std::uint64_t hostHash     = 0;
+    std::uint64_t plantumlHash = 0;
+    hash::computeForFile(pluginDir + "PlantUMLHost.jar", hostHash);
+    hash::computeForFile(pluginDir + "plantuml.jar", plantumlHash);
+    return hash::compute(hash::toHex(hostHash) + hash::toHex(plantumlHash));
+}
 
-    std::unordered_map<std::string, document_part::Image> _cache;
+struct RenderResult {
+    std::string data;
+    std::string error; ///< what the host wrote to stderr while rendering
+    bool        protocolError = false;
+};
 
-    int _stdInPipe[2]  = {0};
-    int _stdOutPipe[2] = {0};
-    int _stdErrPipe[2] = {0};
+/**
+ * @brief Translates the stderr output of the host into errors of the diagram at location.
+ */
+std::vector<Error> hostErrors(const RenderResult& result, const FileLocation& location) {
+    if (result.protocolError) {
+        return {{location, "Protocol error while communicating with plantUml host"}};
+    }
 
-    bool _hostInitialized = false;
-};
+    if (result.error.empty()) {
+        return {};
+    }
 
-PlantUMLPlugin::~PlantUMLPlugin() {
-    if (_hostInitialized) {
-        close(_stdInPipe[1]);
-        close(_stdOutPipe[0]);
-        close(_stdErrPipe[0]);
+    std::vector<std::string> errorInfo;
+    split(result.error, '\n', errorInfo);
+    int         lineNumber = 0;
+    std::string errorText;
+
+    if (!errorInfo.empty() && errorInfo[0] == "ERROR") {
+        if (errorInfo.size() > 1) {
+            try {
+                lineNumber = std::stoi(errorInfo[1]);
+            } catch (...) {
+                return {{location, "Protocol error while reading an error from plantUml host"}};
+            }
+        }
+
+        for (std::vector<std::string>::size_type i = 2; i < errorInfo.size(); i++) {
+            errorText += errorInfo[i];
+        }
+        FileLocation l = location;
+        l.line += lineNumber + 1;
+        return {{l, errorText}};
     }
+    return {};
 }
 
-DocumentPlugin::BlockProcessing PlantUMLPlugin::blockProcessing() const {
-    return BlockProcessing::Required;
-}
+/**
+ * @brief One java process running PlantUMLHost.jar.
+ *
+ * The host protocol has no request ids and diagnostics arrive on stderr separately from the image,
+ * so only one request is sent to the host at a time. Requests of several threads are queued and
+ * sent one after the other by a worker thread, diagrams render concurrently on several hosts.
+ */
+class PlantUMLHost {
+public:
+    ~PlantUMLHost();
 
-std::vector<Error> PlantUMLPlugin::initHost(const ParameterList& parameters, const FileLocation& location) {
-    if (_hostInitialized) {
-        return {};
+    std::vector<Error> start(const std::string& pluginDir, const FileLocation& location);
+
+    std::future<RenderResult> render(const std::string& block);
+
+    /**
+     * @brief Queued requests including the one being rendered.
+     */
+    size_t outstandingRequests() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _queue.size() + (_rendering ? 1 : 0);
     }
 
-    std::string pluginDir;
+private:
+    struct Request {
+        std::string                 data;
+        std::promise<RenderResult> result;
+    };
+
+    void         processRequests();
+    bool         writeRequest(const std::string& data);
+    RenderResult readResponse();
+
+    int   _stdInPipe[2]  = {-1, -1};
+    int   _stdOutPipe[2] = {-1, -1};
+    int   _stdErrPipe[2] = {-1, -1};
+    pid_t _pid           = 0;
+
+    mutable std::mutex      _mutex;
+    std::condition_variable _requestQueued;
+    std::deque<Request>     _queue;
+    bool                    _rendering = false;
+    bool                    _stopping  = false;
+    bool                    _failed    = false; ///< the host is gone or out of sync, requests are not sent anymore
+    std::thread             _worker;
+};
 
-    auto pluginDirIter = parameters.find("pluginDir");
-    if (pluginDirIter != parameters.end()) {
-        pluginDir = pluginDirIter->second.value + '/';
+PlantUMLHost::~PlantUMLHost() {
+    if (_pid == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
     }
+    _requestQueued.notify_one();
+    _worker.join();
+
+    // the host exits at the end of its input
+    close(_stdInPipe[1]);
+    close(_stdOutPipe[0]);
+    close(_stdErrPipe[0]);
+    waitpid(_pid, nullptr, 0);
+}
 
-    const std::string commandLine  = "java -splash:no -jar " + pluginDir + "PlantUMLHost.jar";
-    std::string       stringargs[] = {"java", "-splash:no", "-jar", pluginDir + "PlantUMLHost.jar"};
-    char*             args[]       = {&stringargs[0][0], &stringargs[1][0], &stringargs[2][0], &stringargs[3][0], nullptr};
+std::vector<Error> PlantUMLHost::start(const std::string& pluginDir, const FileLocation& location) {
+    std::string stringargs[] = {"java", "-splash:no", "-jar", pluginDir + "PlantUMLHost.jar"};
+    char*       args[]       = {&stringargs[0][0], &stringargs[1][0], &stringargs[2][0], &stringargs[3][0], nullptr};
 
     posix_spawn_file_actions_t action{};
     pid_t                      pid = 0;
 
-    if ((pipe(_stdInPipe) != 0) || (pipe(_stdOutPipe) != 0) || (pipe(_stdErrPipe) != 0)) {
+    if ((pipe2(_stdInPipe, O_CLOEXEC) != 0) || (pipe2(_stdOutPipe, O_CLOEXEC) != 0) || (pipe2(_stdErrPipe, O_CLOEXEC) != 0)) {
         return {{location, "Internal: Unable to create pipes"}};
     }
 
     posix_spawn_file_actions_init(&action);
 
     posix_spawn_file_actions_adddup2(&action, _stdInPipe[0], 0);
-    posix_spawn_file_actions_addclose(&action, _stdInPipe[1]);
-
     posix_spawn_file_actions_adddup2(&action, _stdOutPipe[1], 1);
-    posix_spawn_file_actions_addclose(&action, _stdOutPipe[0]);
-
     posix_spawn_file_actions_adddup2(&action, _stdErrPipe[1], 2);
-    posix_spawn_file_actions_addclose(&action, _stdErrPipe[0]);
 
-    if (posix_spawnp(&pid, args[0], &action, nullptr, &args[0], nullptr) != 0) {
-        return {{location, "Internal: Unable start plantuml host."}};
-    }
+    const int spawnResult = posix_spawnp(&pid, args[0], &action, nullptr, &args[0], nullptr);
+    posix_spawn_file_actions_destroy(&action);
 
     close(_stdInPipe[0]);
     close(_stdOutPipe[1]);
     close(_stdErrPipe[1]);
 
+    if (spawnResult != 0) {
+        close(_stdInPipe[1]);
+        close(_stdOutPipe[0]);
+        close(_stdErrPipe[0]);
+        return {{location, "Internal: Unable start plantuml host."}};
+    }
+
+    _pid = pid;
+
     int retval = fcntl(_stdErrPipe[0], F_SETFL, fcntl(_stdErrPipe[0], F_GETFL) | O_NONBLOCK);
     if (retval == -1) {
         return {{location, "Internal: Unable to configure stderr pipe"}};
     }
 
-    _hostInitialized = true;
+    _worker = std::thread([this]() { processRequests(); });
     return {};
 }
 
-std::vector<Error> PlantUMLPlugin::process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) {
-    auto initHostErrors = initHost(parameters, location);
-
-    if( !initHostErrors.empty() ){
-        return initHostErrors;
+std::future<RenderResult> PlantUMLHost::render(const std::string& block) {
+    Request request;
+    request.data = "@startuml\n";
+    request.data += block + "\n";
+    request.data += "@enduml \n";
+
+    auto result = request.result.get_future();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_failed) {
+            RenderResult failed;
+            failed.protocolError = true;
+            request.result.set_value(failed);
+            return result;
+        }
+        _queue.push_back(std::move(request));
     }
+    _requestQueued.notify_one();
+    return result;
+}
 
-    auto cachePosition = _cache.find(block);
+void PlantUMLHost::processRequests() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _requestQueued.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            request = std::move(_queue.front());
+            _queue.pop_front();
+            _rendering = true;
+        }
 
-    if (cachePosition != _cache.end()) {
-        document_part::Image image = cachePosition->second;
-        image.location            = location;
-        document.addPart(image);
-        return {};
+        // the response, including what the host writes to stderr, belongs to this request only
+        RenderResult response;
+        if (writeRequest(request.data)) {
+            response = readResponse();
+        } else {
+            response.protocolError = true;
+        }
+        request.result.set_value(response);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rendering = false;
+        if (response.protocolError) {
+            // none of the queued requests will be answered
+            _failed = true;
+            for (auto& queued : _queue) {
+                queued.result.set_value(response);
+            }
+            _queue.clear();
+        }
     }
+}
 
-    std::string outFile = "@startuml\n";
-    outFile += block + "\n";
-    outFile += "@enduml \n";
-
-    write(_stdInPipe[1], outFile.data(), outFile.length());
+bool PlantUMLHost::writeRequest(const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        const auto count = write(_stdInPipe[1], data.data() + written, data.size() - written);
+        if (count <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(count);
+    }
+    return true;
+}
 
-    std::string imageData;
-    int32_t     length = 0;
+RenderResult PlantUMLHost::readResponse() {
+    RenderResult result;
+    int32_t      length = 0;
 
     ssize_t readBytes = read(_stdOutPipe[0], &length, 4);
 
-    if (readBytes != 4) {
-        return {{location, "Protocol error while communicating with plantUml host"}};
+    if (readBytes != 4 || length < 0) {
+        result.protocolError = true;
+        return result;
     }
 
     size_t pos = 0;
-    imageData.resize(static_cast<size_t>(length));
+    result.data.resize(static_cast<size_t>(length));
 
-    while (true) {
-        readBytes = read(_stdOutPipe[0], &imageData[pos], static_cast<size_t>(length) - pos);
+    while (pos < static_cast<size_t>(length)) {
+        readBytes = read(_stdOutPipe[0], &result.data[pos], static_cast<size_t>(length) - pos);
 
         if (readBytes <= 0) {
-            break;
+            result.protocolError = true;
+            return result;
         }
 
         pos += static_cast<size_t>(readBytes);
-
-        if (pos >= static_cast<size_t>(length)) {
-            break;
-        }
     }
 
-    document_part::Text  text(location);
-    document_part::Image image("svg+xml", "svg", imageData, text);
-    document.addPart(image);
-
-    std::string error;
-    char        buffer[8192] = {0};
+    char buffer[8192] = {0};
     while (true) {
         readBytes = read(_stdErrPipe[0], buffer, 8192);
         if (readBytes <= 0) {
             break;
         }
-        error.append(buffer, static_cast<size_t>(readBytes));
+        result.error.append(buffer, static_cast<size_t>(readBytes));
     }
+    return result;
+}
 
-    if (!error.empty()) {
-        std::vector<std::string> errorInfo;
-        split(error, '\n', errorInfo);
-        int         lineNumber = 0;
-        std::string errorText;
+/**
+ * @brief The hosts of the process, shared by all plugin instances (e.g. of the parsers of a batch build),
+ *        so the number of java processes is limited for the whole process and not per document.
+ */
+class PlantUMLHostPool {
+public:
+    static PlantUMLHostPool& instance() {
+        static PlantUMLHostPool pool;
+        return pool;
+    }
 
-        if (!errorInfo.empty() && errorInfo[0] == "ERROR") {
-            if (errorInfo.size() > 1) {
-                try {
-                    lineNumber = std::stoi(errorInfo[1]);
-                } catch (...) {
-                    return {{location, "Protocol error while reading an error from plantUml host"}};
-                }
+    /**
+     * @brief Sends block to the least busy host of pluginDir. Another host is only started, when all running
+     *        hosts are busy and less than maximumHosts hosts run in the process.
+     */
+    std::vector<Error> render(const std::string&         pluginDir,
+                              unsigned                   maximumHosts,
+                              const std::string&         block,
+                              const FileLocation&        location,
+                              std::future<RenderResult>& result) {
+        PlantUMLHost* host = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto                        errors = selectHost(pluginDir, maximumHosts, location, host);
+            if (!errors.empty()) {
+                return errors;
             }
+        }
+        // hosts are never removed, so the host stays valid without the lock
+        result = host->render(block);
+        return {};
+    }
 
-            for (std::vector<std::string>::size_type i = 2; i < errorInfo.size(); i++) {
-                errorText += errorInfo[i];
+private:
+    std::vector<Error> selectHost(const std::string& pluginDir, unsigned maximumHosts, const FileLocation& location, PlantUMLHost*& host) {
+        host = nullptr;
+        for (const auto& candidate : _hosts) {
+            if (candidate.pluginDir == pluginDir && (host == nullptr || candidate.host->outstandingRequests() < host->outstandingRequests())) {
+                host = candidate.host.get();
             }
-            FileLocation l = location;
-            l.line += lineNumber + 1;
-            return {{l, errorText}};
+        }
+
+        // another JVM is only started, when all running hosts are busy
+        if (host != nullptr && (host->outstandingRequests() == 0 || _hosts.size() >= maximumHosts)) {
+            return {};
+        }
+
+        auto newHost = std::make_unique<PlantUMLHost>();
+        auto errors  = newHost->start(pluginDir, location);
+        if (!errors.empty()) {
+            // a running host can still take the request
+            return host != nullptr ? std::vector<Error>() : errors;
+        }
+        host = newHost.get();
+        _hosts.push_back(Host{pluginDir, std::move(newHost)});
+        return {};
+    }
+
+    struct Host {
+        std::string                   pluginDir;
+        std::unique_ptr<PlantUMLHost> host;
+    };
+
+    std::mutex        _mutex;
+    std::vector<Host> _hosts;
+};
+
+unsigned maximumHosts(const ParameterList& parameters) {
+    unsigned result    = std::min(4u, ThreadPool::hardwareConcurrency());
+    auto     hostCount = parameters.find("plantumlHosts");
+    if (hostCount != parameters.end()) {
+        try {
+            result = static_cast<unsigned>(std::stoul(hostCount->second.value));
+        } catch (...) {
+        }
+    }
+    return std::max(1u, result);
+}
+} // namespace
+
+class PlantUMLPlugin : public DocumentPlugin {
+    // DocmaPlugin interface
+public:
+    BlockProcessing blockProcessing() const override;
+    PostProcessing  postProcessing() const override;
+    std::vector<Error> process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) override;
+    std::vector<Error> postProcess(const ParameterList& parameters, const FileLocation& location, Document& document) override;
+
+    void               initDiskCache(const ParameterList& parameters);
+    void               collectRenders(Document& document);
+
+    /**
+     * @brief A diagram, that is rendered by a host. Identical diagrams of a document share one request.
+     */
+    struct Request {
+        std::string                      block;
+        std::shared_future<RenderResult> result;
+    };
+
+    /**
+     * @brief Image part of the document at location, whose data is filled in when the request is answered.
+     */
+    struct Placeholder {
+        FileLocation location;
+        unsigned     request = 0;
+    };
+
+    // the svg data is kept in plain strings, the parts of a document live in its arena
+    std::unordered_map<std::string, std::string> _cache;
+    std::unique_ptr<PlantUMLCache>               _diskCache;
+    bool                                         _diskCacheInitialized = false;
+
+    std::map<unsigned, Request>                _requests;
+    std::unordered_map<std::string, unsigned>  _requestsByBlock;
+    std::vector<Placeholder>                   _placeholders;
+    std::map<FileLocation, std::vector<Error>> _errors;
+    unsigned                                   _nextRequestId = 0;
+};
+
+DocumentPlugin::BlockProcessing PlantUMLPlugin::blockProcessing() const {
+    return BlockProcessing::Required;
+}
+
+DocumentPlugin::PostProcessing PlantUMLPlugin::postProcessing() const {
+    return PostProcessing::Once;
+}
+
+void PlantUMLPlugin::initDiskCache(const ParameterList& parameters) {
+    if (_diskCacheInitialized) {
+        return;
+    }
+    _diskCacheInitialized = true;
+
+    auto directory = parameters.find("plantumlCache");
+    if (directory == parameters.end() || directory->second.value.empty()) {
+        return;
+    }
+
+    std::uint64_t maximumSize = 256;
+    auto          size        = parameters.find("plantumlCacheSize");
+    if (size != parameters.end()) {
+        try {
+            maximumSize = std::stoull(size->second.value);
+        } catch (...) {
         }
     }
 
-    _cache.insert(std::make_pair(block, image));
+    _diskCache = std::make_unique<PlantUMLCache>(directory->second.value, maximumSize * 1024 * 1024, rendererVersion(pluginDirectory(parameters)));
+}
+
+std::vector<Error> PlantUMLPlugin::process(const ParameterList& parameters, const FileLocation& location, Document& document, const std::string& block) {
+    auto cachePosition = _cache.find(block);
+
+    if (cachePosition != _cache.end()) {
+        document_part::Text text(location);
+        document.addPart(document_part::Image("svg+xml", "svg", cachePosition->second, std::move(text)));
+        return {};
+    }
+
+    initDiskCache(parameters);
+
+    // diagrams rendered by a previous run are taken from disk, without starting the host
+    if (_diskCache) {
+        document_part::String imageData;
+        if (_diskCache->load(block, imageData)) {
+            _cache.insert(std::make_pair(block, std::string(imageData)));
+            document_part::Text text(location);
+            document.addPart(document_part::Image("svg+xml", "svg", std::move(imageData), std::move(text)));
+            return {};
+        }
+    }
+
+    auto request = _requestsByBlock.find(block);
+    if (request == _requestsByBlock.end()) {
+        std::future<RenderResult> rendered;
+        auto                      errors = PlantUMLHostPool::instance().render(pluginDirectory(parameters), maximumHosts(parameters), block, location, rendered);
+        if (!errors.empty()) {
+            return errors;
+        }
+
+        const auto id = _nextRequestId++;
+        _requests[id] = Request{block, rendered.share()};
+        request       = _requestsByBlock.insert(std::make_pair(block, id)).first;
+    }
 
+    // the image is added right away, so it keeps its position in the document, its data follows in postProcess
+    document_part::Text text(location);
+    document.addPart(document_part::Image("svg+xml", "svg", document_part::String(), std::move(text)));
+    _placeholders.push_back(Placeholder{location, request->second});
     return {};
 }
 
+void PlantUMLPlugin::collectRenders(Document& document) {
+    if (_placeholders.empty()) {
+        return;
+    }
+
+    // placeholders are found by location, parts of deferred plugins may have been inserted in front of them
+    std::map<FileLocation, document_part::Image*> images;
+    for (auto& part : document.parts()) {
+        auto image = boost::get<document_part::Image>(&part);
+        if (image != nullptr && image->data.empty()) {
+            images[image->location] = image;
+        }
+    }
+
+    for (const auto& placeholder : _placeholders) {
+        const auto& request = _requests[placeholder.request];
+        const auto& result  = request.result.get();
+
+        auto image = images.find(placeholder.location);
+        if (image != images.end()) {
+            image->second->data = result.data;
+        }
+
+        auto errors = hostErrors(result, placeholder.location);
+        if (!errors.empty()) {
+            _errors[placeholder.location] = std::move(errors);
+        }
+    }
+
+    for (const auto& request : _requests) {
+        const auto& result = request.second.result.get();
+        if (!hostErrors(result, FileLocation()).empty()) {
+            continue;
+        }
+
+        if (_diskCache) {
+            _diskCache->store(request.second.block, result.data);
+        }
+        _cache.insert(std::make_pair(request.second.block, result.data));
+    }
+
+    _placeholders.clear();
+    _requests.clear();
+    _requestsByBlock.clear();
+}
+
+std::vector<Error> PlantUMLPlugin::postProcess(const ParameterList& parameters, const FileLocation& location, Document& document) {
+    (void)parameters;
+
+    // called once for every diagram of the document, the first call waits for all of them
+    collectRenders(document);
+
+    auto errors = _errors.find(location);
+    if (errors == _errors.end()) {
+        return {};
+    }
+    auto result = std::move(errors->second);
+    _errors.erase(errors);
+    return result;
+}
+
 EXTENSION_SYSTEM_EXTENSION(
     docmala::DocumentPlugin, PlantUMLPlugin, "plantuml", 1, "Creates an uml diagram form the subsequent block", EXTENSION_SYSTEM_NO_USER_DATA)
 #endif
@@ -179,7 +179,7 @@ bool PlantUMLPlugin::process(const ParameterList& parameters, const FileLocation
     if (cachePosition != _cache.end()) {
         DocumentPart::Image image = cachePosition->second;
         image.line                = location.line;
-        document.addPart(image);
+        document.addPart(std::move(image));
         return true;
     }
 
@@ -258,7 +258,7 @@ bool PlantUMLPlugin::process(const ParameterList& parameters, const FileLocation
         }
     }
 
-    _cache.insert(std::make_pair(block, image));
+    _cache.insert(std::make_pair(block, std::move(image)));
 
     return true;
 }
@@ -39,7 +39,7 @@ public:
     std::unique_ptr<MemoryFile> _file;
     std::vector<Error>          _errors;
 
-    void addCell(size_t& currentCol, size_t currentRow, const document_part::Table::Cell& cell, document_part::Table& table);
+    void addCell(size_t& currentCol, size_t currentRow, document_part::Table::Cell&& cell, document_part::Table& table);
     void ensureTableSize(document_part::Table& table, size_t cols, size_t rows);
 
     void adjustTableSize(document_part::Table& table);
@@ -66,12 +66,15 @@ void TablePlugin::ensureTableSize(document_part::Table& table, size_t cols, size
     }
 }
 
-void TablePlugin::addCell(size_t& currentCol, const size_t currentRow, const document_part::Table::Cell& cell, document_part::Table& table) {
-    ensureTableSize(table, currentCol + cell.columnSpan + 1, currentRow + cell.rowSpan + 1);
+void TablePlugin::addCell(size_t& currentCol, const size_t currentRow, document_part::Table::Cell&& cell, document_part::Table& table) {
+    const auto columnSpan = cell.columnSpan;
+    const auto rowSpan    = cell.rowSpan;
+
+    ensureTableSize(table, currentCol + columnSpan + 1, currentRow + rowSpan + 1);
 
     if (table.cells[currentRow][currentCol].isHiddenBySpan) {
-        auto row = table.cells[currentRow];
-        bool ok  = false;
+        const auto& row = table.cells[currentRow];
+        bool        ok  = false;
         for (; currentCol < row.size(); currentCol++) {
             if (!row[currentCol].isHiddenBySpan) {
                 ok = true;
@@ -80,14 +83,14 @@ void TablePlugin::addCell(size_t& currentCol, const size_t currentRow, const doc
         }
         if (!ok) {
             currentCol += 1;
-            ensureTableSize(table, currentCol + cell.columnSpan + 1, currentRow + cell.rowSpan + 1);
+            ensureTableSize(table, currentCol + columnSpan + 1, currentRow + rowSpan + 1);
         }
     }
 
-    table.cells[currentRow][currentCol] = cell;
+    table.cells[currentRow][currentCol] = std::move(cell);
 
-    for (auto y = currentRow; y <= currentRow + cell.rowSpan; y++) {
-        for (auto x = currentCol; x <= currentCol + cell.columnSpan; x++) {
+    for (auto y = currentRow; y <= currentRow + rowSpan; y++) {
+        for (auto x = currentCol; x <= currentCol + columnSpan; x++) {
             if (x == currentCol && y == currentRow) {
                 continue;
             }
@@ -95,7 +98,7 @@ void TablePlugin::addCell(size_t& currentCol, const size_t currentRow, const doc
         }
     }
 
-    currentCol += cell.columnSpan + 1;
+    currentCol += columnSpan + 1;
 }
 
 void TablePlugin::adjustTableSize(document_part::Table& table) {
@@ -138,7 +141,7 @@ std::vector<Error> TablePlugin::process(const ParameterList& parameters, const F
             FileLocation tableLocation = _file->location();
             tableLocation.line += location.line + 1;
             tableLocation.column -= cellContent.length();
-            std::unique_ptr<IFile> file(new MemoryFile(cellContent, tableLocation));
+            std::unique_ptr<MemoryFile> file(new MemoryFile(cellContent, tableLocation));
 
             document_part::Text text;
             Docmala::readText(file.get(), _errors, '\0', text);
@@ -146,7 +149,7 @@ std::vector<Error> TablePlugin::process(const ParameterList& parameters, const F
             //            ft.text = cellContent;
             //            text.text.push_back(ft);
             document_part::Table::Cell cell;
-            cell.content.emplace_back(text);
+            cell.content.emplace_back(std::move(text));
 
             if (!spanModifier.empty()) {
                 std::istringstream stream(spanModifier);
@@ -161,7 +164,7 @@ std::vector<Error> TablePlugin::process(const ParameterList& parameters, const F
                 cell.rowSpan    = rowSpan;
             }
 
-            addCell(currentCol, currentRow, cell, table);
+            addCell(currentCol, currentRow, std::move(cell), table);
         } else if (readCellResult == ReadCellResult::NextRow) {
             currentRow++;
             currentCol = 0;
@@ -182,7 +185,7 @@ std::vector<Error> TablePlugin::process(const ParameterList& parameters, const F
         spanModifier.clear();
     }
 
-    document.addPart(table);
+    document.addPart(std::move(table));
     // change error line numbers and file name
     (void)block;
     (void)location;
@@ -0,0 +1,451 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "CodeHighlighter.h"
+#include "HtmlSink.h"
+
+#include <algorithm>
+#include <cctype>
+#include <docmala/Hash.h>
+#include <string>
+#include <unordered_map>
+
+using namespace docmala;
+
+namespace {
+/**
+ * @brief What a character starts, when it is found between tokens.
+ */
+enum class Action : unsigned char {
+    Plain,
+    Identifier,
+    Number,
+    String, ///< quoted, with backslash escapes
+    RawString, ///< quoted, without escapes
+    Slash, ///< may start a C++ comment
+    Hash, ///< may start a comment or a preprocessor directive
+    Variable ///< shell variable
+};
+
+enum class HashMeaning {
+    None,
+    Comment, ///< '#' starts a comment anywhere
+    WordComment, ///< '#' starts a comment at the beginning of a word
+    Preprocessor ///< '#' starts a directive, if it is the first character of a line
+};
+
+struct ViewHash {
+    std::size_t operator()(boost::string_view view) const {
+        return static_cast<std::size_t>(hash::compute(view));
+    }
+};
+
+/**
+ * @brief The lexical structure of a language. The lexer looks up the action of every character between tokens
+ *        in a table, so most characters cost a single lookup.
+ */
+struct Language {
+    Language(const char* quotes, const char* rawQuotes) {
+        std::fill(std::begin(actions), std::end(actions), Action::Plain);
+        for (int c = 0; c < 256; c++) {
+            if (std::isalpha(c) != 0 || c == '_') {
+                actions[c] = Action::Identifier;
+            } else if (std::isdigit(c) != 0) {
+                actions[c] = Action::Number;
+            }
+        }
+        for (; *quotes != 0; quotes++) {
+            actions[static_cast<unsigned char>(*quotes)] = Action::String;
+        }
+        for (; *rawQuotes != 0; rawQuotes++) {
+            actions[static_cast<unsigned char>(*rawQuotes)] = Action::RawString;
+        }
+    }
+
+    // words points to a string literal, so the views into it stay valid
+    void addWords(const char* className, const char* words) {
+        boost::string_view list(words);
+        while (!list.empty()) {
+            const auto end  = std::min(list.find(' '), list.size());
+            const auto word = list.substr(0, end);
+            if (!word.empty()) {
+                classNames.emplace(word, className);
+                longestWord = std::max(longestWord, word.size());
+            }
+            list.remove_prefix(std::min(end + 1, list.size()));
+        }
+    }
+
+    const char* classOf(boost::string_view word) const {
+        if (word.size() > longestWord) {
+            return nullptr;
+        }
+        auto className = classNames.find(word);
+        return className != classNames.end() ? className->second : nullptr;
+    }
+
+    bool isIdentifier(char c) const {
+        const auto action = actions[static_cast<unsigned char>(c)];
+        return action == Action::Identifier || action == Action::Number;
+    }
+
+    Action                                                        actions[256];
+    std::unordered_map<boost::string_view, const char*, ViewHash> classNames;
+    std::size_t                                                   longestWord      = 0;
+    HashMeaning                                                   hash             = HashMeaning::None;
+    bool                                                          tripleQuotes     = false;
+    bool                                                          rawStrings       = false;
+    bool                                                          digitSeparators  = false;
+    bool                                                          attributes       = false;
+    bool                                                          multiLineStrings = false;
+};
+
+struct Languages {
+    Languages()
+        : cpp("\"'", "")
+        , python("\"'", "")
+        , json("\"", "")
+        , shell("\"", "'") {
+        cpp.actions[static_cast<unsigned char>('/')] = Action::Slash;
+        cpp.actions[static_cast<unsigned char>('#')] = Action::Hash;
+        cpp.hash                                     = HashMeaning::Preprocessor;
+        cpp.rawStrings                               = true;
+        cpp.digitSeparators                          = true;
+        cpp.addWords("hljs-keyword",
+                     "alignas alignof and and_eq asm auto bitand bitor break case catch class compl concept const consteval constexpr "
+                     "constinit const_cast continue co_await co_return co_yield decltype default delete do dynamic_cast else enum explicit "
+                     "export extern final for friend goto if inline mutable namespace new noexcept not not_eq operator or or_eq override "
+                     "private protected public register reinterpret_cast requires return sizeof static static_assert static_cast struct "
+                     "switch template this thread_local throw try typedef typeid typename union using virtual volatile while xor xor_eq "
+                     "bool char char8_t char16_t char32_t double float int long short signed unsigned void wchar_t");
+        cpp.addWords("hljs-literal", "true false nullptr NULL");
+        cpp.addWords("hljs-built_in",
+                     "std string wstring string_view vector map set multimap multiset unordered_map unordered_set list deque array "
+                     "pair tuple optional variant unique_ptr shared_ptr weak_ptr make_unique make_shared size_t ptrdiff_t "
+                     "cin cout cerr clog endl printf fprintf snprintf malloc free move forward");
+
+        python.actions[static_cast<unsigned char>('#')] = Action::Hash;
+        python.hash                                     = HashMeaning::Comment;
+        python.tripleQuotes                             = true;
+        python.addWords("hljs-keyword",
+                        "and as assert async await break class continue def del elif else except finally for from global if import "
+                        "in is lambda nonlocal not or pass raise return try while with yield");
+        python.addWords("hljs-literal", "True False None");
+        python.addWords("hljs-built_in",
+                        "abs all any bool bytes dict enumerate filter float format getattr hasattr int isinstance iter len list map "
+                        "max min next object open print range repr reversed set setattr sorted str sum super tuple type zip");
+
+        json.attributes = true;
+        json.addWords("hljs-literal", "true false null");
+
+        shell.actions[static_cast<unsigned char>('#')] = Action::Hash;
+        shell.actions[static_cast<unsigned char>('$')] = Action::Variable;
+        shell.hash                                     = HashMeaning::WordComment;
+        shell.multiLineStrings                         = true;
+        shell.addWords("hljs-keyword", "if then else elif fi for while until in do done case esac function select time return break continue");
+        shell.addWords("hljs-built_in",
+                       "alias bg cd command declare echo eval exec exit export false fg getopts hash jobs kill let local printf pwd read "
+                       "readonly set shift source test trap true type ulimit umask unalias unset wait");
+
+        for (const char* name : {"cpp", "c++", "cxx", "cc", "c", "h", "hpp"}) {
+            byName.emplace(name, &cpp);
+        }
+        for (const char* name : {"python", "py"}) {
+            byName.emplace(name, &python);
+        }
+        byName.emplace("json", &json);
+        for (const char* name : {"bash", "sh", "shell", "zsh"}) {
+            byName.emplace(name, &shell);
+        }
+    }
+
+    Language                                         cpp;
+    Language                                         python;
+    Language                                         json;
+    Language                                         shell;
+    std::unordered_map<std::string, const Language*> byName;
+};
+
+const Language* findLanguage(boost::string_view name) {
+    static const Languages languages;
+
+    std::string lowerName(name.begin(), name.end());
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+    auto language = languages.byName.find(lowerName);
+    return language != languages.byName.end() ? language->second : nullptr;
+}
+
+class Lexer {
+public:
+    Lexer(const Language& language, HtmlSink& sink, boost::string_view code)
+        : _language(language)
+        , _sink(sink)
+        , _code(code) {}
+
+    void run();
+
+private:
+    // writes the plain text before begin, then the token [begin, end) wrapped in a span
+    void emit(std::size_t begin, std::size_t end, const char* className);
+
+    std::size_t endOfLine(std::size_t position) const;
+    std::size_t endOfNumber(std::size_t position) const;
+    std::size_t endOfString(std::size_t position, bool escapes) const;
+    std::size_t endOfRawString(std::size_t quote) const;
+    std::size_t endOfDirective(std::size_t position) const;
+    std::size_t endOfVariable(std::size_t position) const;
+    bool        startsLine(std::size_t position) const;
+
+    const Language&    _language;
+    HtmlSink&          _sink;
+    boost::string_view _code;
+    std::size_t        _plainBegin = 0;
+};
+
+void Lexer::run() {
+    const auto  size     = _code.size();
+    std::size_t position = 0;
+
+    while (position < size) {
+        const char c = _code[position];
+
+        switch (_language.actions[static_cast<unsigned char>(c)]) {
+            case Action::Plain:
+                position++;
+                break;
+            case Action::Identifier: {
+                auto end = position + 1;
+                while (end < size && _language.isIdentifier(_code[end])) {
+                    end++;
+                }
+                const auto word = _code.substr(position, end - position);
+                if (_language.rawStrings && end < size && _code[end] == '"'
+                    && (word == "R" || word == "LR" || word == "uR" || word == "UR" || word == "u8R")) {
+                    end = endOfRawString(end);
+                    emit(position, end, "hljs-string");
+                } else if (auto className = _language.classOf(word)) {
+                    emit(position, end, className);
+                }
+                position = end;
+                break;
+            }
+            case Action::Number: {
+                const auto end = endOfNumber(position);
+                emit(position, end, "hljs-number");
+                position = end;
+                break;
+            }
+            case Action::String: {
+                const auto  end       = endOfString(position, true);
+                const char* className = "hljs-string";
+                if (_language.attributes) {
+                    auto next = end;
+                    while (next < size && std::isspace(static_cast<unsigned char>(_code[next])) != 0) {
+                        next++;
+                    }
+                    if (next < size && _code[next] == ':') {
+                        className = "hljs-attr";
+                    }
+                }
+                emit(position, end, className);
+                position = end;
+                break;
+            }
+            case Action::RawString: {
+                const auto end = endOfString(position, false);
+                emit(position, end, "hljs-string");
+                position = end;
+                break;
+            }
+            case Action::Slash: {
+                const char next = position + 1 < size ? _code[position + 1] : '\0';
+                if (next == '/') {
+                    const auto end = endOfLine(position);
+                    emit(position, end, "hljs-comment");
+                    position = end;
+                } else if (next == '*') {
+                    const auto close = _code.find("*/", position + 2);
+                    const auto end   = close == boost::string_view::npos ? size : close + 2;
+                    emit(position, end, "hljs-comment");
+                    position = end;
+                } else {
+                    position++;
+                }
+                break;
+            }
+            case Action::Hash: {
+                std::size_t end = position;
+                if (_language.hash == HashMeaning::Comment
+                    || (_language.hash == HashMeaning::WordComment && (position == 0 || std::isspace(static_cast<unsigned char>(_code[position - 1])) != 0))) {
+                    end = endOfLine(position);
+                    emit(position, end, "hljs-comment");
+                } else if (_language.hash == HashMeaning::Preprocessor && startsLine(position)) {
+                    end = endOfDirective(position);
+                    emit(position, end, "hljs-meta");
+                }
+                position = std::max(end, position + 1);
+                break;
+            }
+            case Action::Variable: {
+                const auto end = endOfVariable(position);
+                if (end > position + 1) {
+                    emit(position, end, "hljs-variable");
+                }
+                position = std::max(end, position + 1);
+                break;
+            }
+        }
+    }
+
+    writeEscaped(_sink, _code.substr(_plainBegin));
+}
+
+void Lexer::emit(std::size_t begin, std::size_t end, const char* className) {
+    writeEscaped(_sink, _code.substr(_plainBegin, begin - _plainBegin));
+    _sink << "<span class=\"" << className << "\">";
+    writeEscaped(_sink, _code.substr(begin, end - begin));
+    _sink << "</span>";
+    _plainBegin = end;
+}
+
+std::size_t Lexer::endOfLine(std::size_t position) const {
+    return std::min(_code.find('\n', position), _code.size());
+}
+
+std::size_t Lexer::endOfNumber(std::size_t position) const {
+    const bool hexadecimal = _code[position] == '0' && position + 1 < _code.size() && (_code[position + 1] == 'x' || _code[position + 1] == 'X');
+
+    auto end = position + 1;
+    for (; end < _code.size(); end++) {
+        const char c = _code[end];
+        if (std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '.' || c == '_' || (c == '\'' && _language.digitSeparators)) {
+            continue;
+        }
+        // signed exponent
+        const char previous = _code[end - 1];
+        if ((c == '+' || c == '-') && !hexadecimal && (previous == 'e' || previous == 'E')) {
+            continue;
+        }
+        break;
+    }
+    return end;
+}
+
+std::size_t Lexer::endOfString(std::size_t position, bool escapes) const {
+    const char quote = _code[position];
+    const auto size  = _code.size();
+
+    if (_language.tripleQuotes && position + 2 < size && _code[position + 1] == quote && _code[position + 2] == quote) {
+        const char delimiter[] = {quote, quote, quote};
+        const auto close       = _code.find(boost::string_view(delimiter, 3), position + 3);
+        return close == boost::string_view::npos ? size : close + 3;
+    }
+
+    for (auto end = position + 1; end < size; end++) {
+        const char c = _code[end];
+        if (c == '\\' && escapes) {
+            end++;
+        } else if (c == quote) {
+            return end + 1;
+        } else if (c == '\n' && !_language.multiLineStrings) {
+            // unterminated
+            return end;
+        }
+    }
+    return size;
+}
+
+std::size_t Lexer::endOfRawString(std::size_t quote) const {
+    // R"delimiter( ... )delimiter"
+    const auto open = _code.find('(', quote + 1);
+    if (open == boost::string_view::npos || open - quote > 17) {
+        return endOfString(quote, true);
+    }
+
+    std::string close = ")";
+    close.append(_code.data() + quote + 1, open - quote - 1);
+    close += '"';
+
+    const auto end = _code.find(boost::string_view(close), open + 1);
+    return end == boost::string_view::npos ? _code.size() : end + close.size();
+}
+
+std::size_t Lexer::endOfDirective(std::size_t position) const {
+    auto end = endOfLine(position);
+    // continued lines
+    while (end < _code.size()) {
+        auto last = end;
+        if (last > position && _code[last - 1] == '\r') {
+            last--;
+        }
+        if (last == position || _code[last - 1] != '\\') {
+            break;
+        }
+        end = endOfLine(end + 1);
+    }
+    return end;
+}
+
+std::size_t Lexer::endOfVariable(std::size_t position) const {
+    const auto size = _code.size();
+    if (position + 1 >= size) {
+        return position + 1;
+    }
+
+    const char next = _code[position + 1];
+    if (next == '{') {
+        const auto close = _code.find('}', position + 2);
+        return close == boost::string_view::npos ? size : close + 1;
+    }
+    if (_language.isIdentifier(next) && std::isdigit(static_cast<unsigned char>(next)) == 0) {
+        auto end = position + 2;
+        while (end < size && _language.isIdentifier(_code[end])) {
+            end++;
+        }
+        return end;
+    }
+    if (std::isdigit(static_cast<unsigned char>(next)) != 0 || boost::string_view("?@#$!*-").find(next) != boost::string_view::npos) {
+        return position + 2;
+    }
+    return position + 1;
+}
+
+bool Lexer::startsLine(std::size_t position) const {
+    while (position > 0 && (_code[position - 1] == ' ' || _code[position - 1] == '\t')) {
+        position--;
+    }
+    return position == 0 || _code[position - 1] == '\n';
+}
+} // namespace
+
+bool highlighter::isSupported(boost::string_view language) {
+    return findLanguage(language) != nullptr;
+}
+
+bool highlighter::write(HtmlSink& sink, boost::string_view language, boost::string_view code) {
+    const auto definition = findLanguage(language);
+    if (definition == nullptr) {
+        return false;
+    }
+
+    Lexer(*definition, sink, code).run();
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "HtmlOutput_global.h"
+#include <boost/utility/string_view.hpp>
+
+namespace docmala {
+class HtmlSink;
+
+namespace highlighter {
+
+/**
+ * @brief True, if code blocks of language (for example "cpp", "python", "json" or "bash") can be highlighted.
+ */
+HTMLOUTPUT_API bool isSupported(boost::string_view language);
+
+/**
+ * @brief Writes code escaped, with its tokens wrapped in spans carrying the class names of highlight.js,
+ *        so the highlight style sheet applies without running highlight.js in the browser.
+ * @return false, if the language is not supported, nothing is written then
+ */
+HTMLOUTPUT_API bool write(HtmlSink& sink, boost::string_view language, boost::string_view code);
+
+} // namespace highlighter
+} // namespace docmala
@@ -0,0 +1,27 @@
+# Writes the HTML scripts and style sheets as constexpr byte arrays into a header, so they can be
+# compiled into the plugin. Called at build time:
+#   cmake -DOUTPUT=<header> -DCODE_HIGHLIGHT_SCRIPT=<file> -DDEFAULT_STYLE=<file> -DCODE_HIGHLIGHT_STYLE=<file> -P EmbedAssets.cmake
+
+set(content "// generated by EmbedAssets.cmake, do not edit\n#pragma once\n\n#include <cstddef>\n\nnamespace docmala {\nnamespace html_assets {\n")
+
+set(line "")
+foreach(i RANGE 15)
+    string(APPEND line "0x[0-9a-f][0-9a-f],")
+endforeach()
+
+macro(embed_asset name file)
+    file(READ "${file}" bytes HEX)
+    string(LENGTH "${bytes}" length)
+    math(EXPR size "${length} / 2")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${bytes}")
+    # 16 bytes per line
+    string(REGEX REPLACE "(${line})" "\\1\n    " bytes "${bytes}")
+    string(APPEND content "\nconstexpr std::size_t   ${name}Size = ${size};\nconstexpr unsigned char ${name}[] = {\n    ${bytes}0};\n")
+endmacro()
+
+embed_asset(codeHighlightScript "${CODE_HIGHLIGHT_SCRIPT}")
+embed_asset(defaultStyle "${DEFAULT_STYLE}")
+embed_asset(codeHighlightStyle "${CODE_HIGHLIGHT_STYLE}")
+
+string(APPEND content "\n} // namespace html_assets\n} // namespace docmala\n")
+file(WRITE "${OUTPUT}" "${content}")
@@ -19,60 +19,69 @@
         along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <docmala/Base64.h>
 #include <docmala/DocmaPlugin.h>
+#include <docmala/Hash.h>
+#include <docmala/ThreadPool.h>
 #include <extension_system/Extension.hpp>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
+#include "CodeHighlighter.h"
 #include "HtmlOutput.h"
+#include "HtmlSink.h"
+
+#ifdef DOCMALA_HTML_EMBEDDED_ASSETS
+#include "HtmlAssets.h"
+#endif
 
 namespace {
-const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                                 "abcdefghijklmnopqrstuvwxyz"
-                                 "0123456789+/";
-
-std::string base64_encode(const std::string& inputData) {
-    std::string   ret;
-    int           i = 0;
-    int           j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-
-    for (char data : inputData) {
-        char_array_3[i++] = static_cast<unsigned char>(data);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = static_cast<unsigned char>(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
-            char_array_4[2] = static_cast<unsigned char>(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for (i = 0; (i < 4); i++) {
-                ret += base64_chars[char_array_4[i]];
-            }
-            i = 0;
-        }
-    }
+/**
+ * @brief Workers shared by all parallel renders of the process.
+ */
+docmala::ThreadPool& renderPool() {
+    static docmala::ThreadPool pool;
+    return pool;
+}
 
-    if (i != 0) {
-        for (j = i; j < 3; j++) {
-            char_array_3[j] = '\0';
-        }
+/**
+ * @brief Workers writing image files. Writing files is bound by I/O, so a few workers suffice.
+ */
+docmala::ThreadPool& imageWriterPool() {
+    static docmala::ThreadPool pool(4);
+    return pool;
+}
+
+/**
+ * @brief Writes data to fileName, unless the file already has this content. So rebuilds keep unchanged
+ *        images untouched, including their modification time.
+ */
+bool writeFileIfChanged(const std::string& fileName, boost::string_view data) {
+    std::uint64_t existingHash = 0;
+    if (docmala::hash::computeForFile(fileName, existingHash) && existingHash == docmala::hash::compute(data)) {
+        return true;
+    }
 
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = static_cast<unsigned char>(((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4));
-        char_array_4[2] = static_cast<unsigned char>(((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6));
-        char_array_4[3] = char_array_3[2] & 0x3f;
+    std::ofstream file(fileName, std::ofstream::binary | std::ofstream::out);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+    return !file.fail();
+}
 
-        for (j = 0; (j < i + 1); j++) {
-            ret += base64_chars[char_array_4[j]];
-        }
+void writeBase64(docmala::HtmlSink& outFile, boost::string_view data) {
+    // chunks are a multiple of 3 bytes, so padding only occurs at the very end
+    const std::size_t chunkSize = outFile.bufferSize() / 4 * 3;
 
-        while ((i++ < 3)) {
-            ret += '=';
-        }
+    for (std::size_t offset = 0; offset < data.size(); offset += chunkSize) {
+        const auto size   = std::min(chunkSize, data.size() - offset);
+        const auto output = outFile.reserve(docmala::base64::encodedSize(size));
+        outFile.commit(docmala::base64::encode(reinterpret_cast<const unsigned char*>(data.data()) + offset, size, output));
     }
-
-    return ret;
 }
 
 std::string escapeAnchor(const std::string& anchor) {
@@ -89,6 +98,10 @@ class HtmlOutputPlugin : public OutputPlugin {
     // OutputPlugin interface
 public:
     bool write(const ParameterList& parameters, const Document& document) override;
+    std::vector<std::string> outputFiles() const override;
+
+private:
+    std::vector<std::string> _outputFiles;
 };
 
 void replaceAll(std::string& source, const std::string& from, const std::string& to) {
@@ -109,6 +122,243 @@ void replaceAll(std::string& source, const std::string& from, const std::string&
     source.swap(newString);
 }
 
+namespace {
+/**
+ * @brief The scripts and style sheets included in the head of every HTML file, ready to be written.
+ */
+struct StaticAssets {
+    struct Asset {
+        std::string content;
+        std::string sharedFileName; ///< content hashed name, the asset is written to with sharedAssets
+    };
+
+    Asset       codeHighlightScript;
+    std::string inlineCodeHighlightScript; ///< escaped for a script element
+    Asset       defaultStyle;
+    Asset       codeHighlightStyle;
+};
+
+#ifndef DOCMALA_HTML_EMBEDDED_ASSETS
+std::string readAsset(const std::string& fileName) {
+    std::string   content;
+    std::ifstream reader(fileName, std::ios::in | std::ios::binary);
+    if (reader) {
+        reader.seekg(0, std::ios::end);
+        content.resize(static_cast<std::string::size_type>(reader.tellg()));
+        reader.seekg(0, std::ios::beg);
+        reader.read(&content[0], static_cast<std::streamsize>(content.size()));
+    }
+    return content;
+}
+#endif
+
+std::string sharedFileName(const std::string& name, const std::string& extension, const std::string& content) {
+    return name + "_" + hash::toHex(hash::compute(content)) + extension;
+}
+
+StaticAssets loadAssets(const std::string& pluginDir) {
+    StaticAssets assets;
+
+#ifdef DOCMALA_HTML_EMBEDDED_ASSETS
+    (void)pluginDir;
+    assets.codeHighlightScript.content.assign(reinterpret_cast<const char*>(html_assets::codeHighlightScript), html_assets::codeHighlightScriptSize);
+    assets.defaultStyle.content.assign(reinterpret_cast<const char*>(html_assets::defaultStyle), html_assets::defaultStyleSize);
+    assets.codeHighlightStyle.content.assign(reinterpret_cast<const char*>(html_assets::codeHighlightStyle), html_assets::codeHighlightStyleSize);
+#else
+    assets.codeHighlightScript.content = readAsset(pluginDir + "outputPluginHtmlCodeHighlight.js");
+    assets.defaultStyle.content        = readAsset(pluginDir + "outputPluginHtmlDefaultStyle.css");
+    assets.codeHighlightStyle.content  = readAsset(pluginDir + "outputPluginHtmlCodeHighlight.css");
+#endif
+
+    assets.codeHighlightScript.sharedFileName = sharedFileName("outputPluginHtmlCodeHighlight", ".js", assets.codeHighlightScript.content);
+    assets.defaultStyle.sharedFileName        = sharedFileName("outputPluginHtmlDefaultStyle", ".css", assets.defaultStyle.content);
+    assets.codeHighlightStyle.sharedFileName  = sharedFileName("outputPluginHtmlCodeHighlight", ".css", assets.codeHighlightStyle.content);
+
+    assets.inlineCodeHighlightScript = assets.codeHighlightScript.content;
+    replaceAll(assets.inlineCodeHighlightScript, "<script", "&lt;script");
+    replaceAll(assets.inlineCodeHighlightScript, "</script", "&lt;/script");
+    return assets;
+}
+
+/**
+ * @brief Assets are loaded once per plugin directory, afterwards all renders of the process share them read-only.
+ */
+const StaticAssets& staticAssets(const std::string& pluginDir) {
+    static std::mutex                                                 mutex;
+    static std::map<std::string, std::unique_ptr<const StaticAssets>> loaded;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto&                       assets = loaded[pluginDir];
+    if (!assets) {
+        assets = std::make_unique<const StaticAssets>(loadAssets(pluginDir));
+    }
+    return *assets;
+}
+
+/**
+ * @brief Writes a shared asset to directory, unless it is already there. Documents rendered in parallel
+ *        share the same assets, so the writes are serialized.
+ */
+bool writeSharedAsset(const std::string& directory, const StaticAssets::Asset& asset) {
+    static std::mutex           mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    return writeFileIfChanged(directory + asset.sharedFileName, asset.content);
+}
+
+unsigned int readBigEndian16(boost::string_view data, std::size_t position) {
+    return static_cast<unsigned int>(static_cast<unsigned char>(data[position]) << 8 | static_cast<unsigned char>(data[position + 1]));
+}
+
+unsigned int readBigEndian32(boost::string_view data, std::size_t position) {
+    return readBigEndian16(data, position) << 16 | readBigEndian16(data, position + 2);
+}
+
+unsigned int readLittleEndian16(boost::string_view data, std::size_t position) {
+    return static_cast<unsigned int>(static_cast<unsigned char>(data[position + 1]) << 8 | static_cast<unsigned char>(data[position]));
+}
+
+bool jpegSize(boost::string_view data, double& width, double& height) {
+    std::size_t position = 2;
+    while (position + 4 <= data.size() && static_cast<unsigned char>(data[position]) == 0xFF) {
+        const auto marker = static_cast<unsigned char>(data[position + 1]);
+        if (marker == 0xFF) { // fill byte
+            position++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) { // markers without length
+            position += 2;
+            continue;
+        }
+        // start of frame, except DHT, JPG and DAC, which share the range
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (position + 9 > data.size()) {
+                return false;
+            }
+            height = readBigEndian16(data, position + 5);
+            width  = readBigEndian16(data, position + 7);
+            return true;
+        }
+        position += 2 + readBigEndian16(data, position + 2);
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the value of attribute in tag, e.g. the attributes of the svg root element.
+ */
+boost::string_view attributeValue(boost::string_view tag, boost::string_view attribute) {
+    for (auto position = tag.find(attribute); position != boost::string_view::npos; position = tag.find(attribute, position + 1)) {
+        if (position == 0 || std::isspace(static_cast<unsigned char>(tag[position - 1])) == 0) {
+            continue;
+        }
+        auto next = position + attribute.size();
+        while (next < tag.size() && std::isspace(static_cast<unsigned char>(tag[next])) != 0) {
+            next++;
+        }
+        if (next >= tag.size() || tag[next] != '=') {
+            continue;
+        }
+        next++;
+        while (next < tag.size() && std::isspace(static_cast<unsigned char>(tag[next])) != 0) {
+            next++;
+        }
+        if (next >= tag.size() || (tag[next] != '"' && tag[next] != '\'')) {
+            return {};
+        }
+        const auto end = tag.find(tag[next], next + 1);
+        if (end == boost::string_view::npos) {
+            return {};
+        }
+        return tag.substr(next + 1, end - next - 1);
+    }
+    return {};
+}
+
+/**
+ * @brief Converts an absolute svg length to css pixels, relative lengths like percentages yield false.
+ */
+bool svgLength(boost::string_view text, double& length) {
+    const std::string value(text.begin(), text.end());
+    char*             unitBegin = nullptr;
+    length                      = std::strtod(value.c_str(), &unitBegin);
+    if (unitBegin == value.c_str() || length <= 0) {
+        return false;
+    }
+
+    const std::string unit(unitBegin);
+    if (unit.empty() || unit == "px") {
+        return true;
+    }
+    const std::pair<const char*, double> pixelsPerUnit[] = {{"mm", 96 / 25.4}, {"cm", 96 / 2.54}, {"in", 96}, {"pt", 96 / 72.0}, {"pc", 16}};
+    for (const auto& factor : pixelsPerUnit) {
+        if (unit == factor.first) {
+            length *= factor.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool svgSize(boost::string_view data, double& width, double& height) {
+    auto begin = data.find("<svg");
+    while (begin != boost::string_view::npos && begin + 4 < data.size() && std::isspace(static_cast<unsigned char>(data[begin + 4])) == 0) {
+        begin = data.find("<svg", begin + 4);
+    }
+    if (begin == boost::string_view::npos) {
+        return false;
+    }
+    const auto end = data.find('>', begin);
+    if (end == boost::string_view::npos) {
+        return false;
+    }
+    const auto tag = data.substr(begin, end - begin);
+
+    if (svgLength(attributeValue(tag, "width"), width) && svgLength(attributeValue(tag, "height"), height)) {
+        return true;
+    }
+
+    // "min-x min-y width height"
+    const auto        viewBox = attributeValue(tag, "viewBox");
+    std::string       values(viewBox.begin(), viewBox.end());
+    std::replace(values.begin(), values.end(), ',', ' ');
+    std::istringstream stream(values);
+    double             minX = 0;
+    double             minY = 0;
+    return static_cast<bool>(stream >> minX >> minY >> width >> height) && width > 0 && height > 0;
+}
+
+/**
+ * @brief Reads the intrinsic size of an image in css pixels from its header.
+ * @return false, if the format is unknown or the size can not be determined
+ */
+bool imageSize(const document_part::Image& image, double& width, double& height) {
+    const boost::string_view data(image.data);
+    if (data.size() >= 24 && data.substr(0, 8) == boost::string_view("\x89PNG\r\n\x1a\n", 8) && data.substr(12, 4) == "IHDR") {
+        width  = readBigEndian32(data, 16);
+        height = readBigEndian32(data, 20);
+        return width > 0 && height > 0;
+    }
+    if (data.size() >= 10 && (data.substr(0, 6) == "GIF87a" || data.substr(0, 6) == "GIF89a")) {
+        width  = readLittleEndian16(data, 6);
+        height = readLittleEndian16(data, 8);
+        return width > 0 && height > 0;
+    }
+    if (data.size() >= 4 && static_cast<unsigned char>(data[0]) == 0xFF && static_cast<unsigned char>(data[1]) == 0xD8) {
+        return jpegSize(data, width, height) && width > 0 && height > 0;
+    }
+    if (image.fileExtension == "svg") {
+        return svgSize(data, width, height);
+    }
+    return false;
+}
+
+std::string formatLength(double length) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6g", length);
+    return buffer;
+}
+} // namespace
+
 std::string id(const document_part::VisualElement& element) {
     if (element.location.valid()) {
         return std::string(" id=\"line_") + std::to_string(element.location.line) + "\"";
@@ -116,7 +366,7 @@ std::string id(const document_part::VisualElement& element) {
     return "";
 }
 
-void writeFormatedText(std::stringstream& outFile, const document_part::FormatedText& text) {
+void writeFormatedText(HtmlSink& outFile, const document_part::FormatedText& text) {
     if (text.bold) {
         outFile << "<b>";
     }
@@ -132,10 +382,7 @@ void writeFormatedText(std::stringstream& outFile, const document_part::Formated
     if (text.monospaced) {
         outFile << "<tt>";
     }
-    std::string txt = text.text;
-    replaceAll(txt, "<", "&lt;");
-    replaceAll(txt, ">", "&gt;");
-    outFile << txt;
+    writeEscaped(outFile, text.text);
 
     if (text.bold) {
         outFile << "</b>";
@@ -154,23 +401,35 @@ void writeFormatedText(std::stringstream& outFile, const document_part::Formated
     }
 }
 
-void writeCode(std::stringstream& outFile, const document_part::Code& code) {
+void writeCode(HtmlSink& outFile, const document_part::Code& code, bool highlight) {
+    if (highlight) {
+        // highlighted here, so the code is already styled when the page is shown
+        outFile << "<pre" << id(code) << "> <code class=\"hljs";
+        if (!code.type.empty()) {
+            outFile << " ";
+            writeEscaped(outFile, code.type, Escape::Attribute);
+        }
+        outFile << "\">\n";
+        if (!highlighter::write(outFile, code.type, code.code)) {
+            writeEscaped(outFile, code.code);
+        }
+        outFile << "</code> </pre>\n";
+        return;
+    }
+
     if (!code.type.empty()) {
-        outFile << "<pre" << id(code) << "> <code class=\"" << code.type << "\">\n";
+        outFile << "<pre" << id(code) << "> <code class=\"";
+        writeEscaped(outFile, code.type, Escape::Attribute);
+        outFile << "\">\n";
     } else {
         outFile << "<pre> <code>\n";
     }
 
-    std::string cde = code.code;
-
-    replaceAll(cde, "<", "&lt;");
-    replaceAll(cde, ">", "&gt;");
-
-    outFile << cde;
+    writeEscaped(outFile, code.code);
     outFile << "</code> </pre>\n";
 }
 
-void HtmlOutput::writeTable(std::stringstream& outFile, const document_part::Table& table) {
+void HtmlOutput::writeTable(HtmlSink& outFile, const document_part::Table& table) {
     outFile << "<table>\n";
     bool firstRow = true;
     for (const auto& row : table.cells) {
@@ -212,7 +471,7 @@ void HtmlOutput::writeTable(std::stringstream& outFile, const document_part::Tab
     outFile << "</table>\n";
 }
 
-void HtmlOutput::writeListEntries(std::stringstream& outFile, const std::vector<document_part::List::Entry>& entries, bool isGenerated) {
+void HtmlOutput::writeListEntries(HtmlSink& outFile, const document_part::Vector<document_part::List::Entry>& entries, bool isGenerated) {
     if (entries.empty())
         return;
 
@@ -234,23 +493,25 @@ void HtmlOutput::writeListEntries(std::stringstream& outFile, const std::vector<
 
     for (const auto& entry : entries) {
         outFile << "<li> ";
-        writeDocumentParts(outFile, {entry.text}, isGenerated);
+        writeText(outFile, entry.text, isGenerated);
         writeListEntries(outFile, entry.entries, isGenerated);
         outFile << " </li>\n";
     }
     outFile << "</" << type << ">\n";
 }
 
-void HtmlOutput::writeList(std::stringstream& outFile, const document_part::List& list, bool isGenerated) {
+void HtmlOutput::writeList(HtmlSink& outFile, const document_part::List& list, bool isGenerated) {
     writeListEntries(outFile, list.entries, isGenerated);
 }
 
-void HtmlOutput::prepare(const std::vector<document_part::Variant>& documentParts) {
+void HtmlOutput::prepare(const document_part::PartList& documentParts) {
     auto previous = documentParts.end();
 
     for (auto part = documentParts.begin(); part != documentParts.end(); previous = part, part++) {
         if (auto doc = boost::get<document_part::GeneratedDocument>(&*part)) {
-            prepare(doc->document);
+            prepare(doc->parts());
+        } else {
+            numberImages(*part);
         }
         auto headline = boost::get<document_part::Headline>(&*part);
         auto caption  = boost::get<document_part::Caption>(&*part);
@@ -322,10 +583,134 @@ void HtmlOutput::prepare(const std::vector<document_part::Variant>& documentPart
     }
 }
 
-void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vector<document_part::Variant>& documentParts, bool isGenerated) {
+void HtmlOutput::numberImages(const document_part::Variant& part) {
+    // visits images in the order writeDocumentParts renders them
+    if (auto doc = boost::get<document_part::GeneratedDocument>(&part)) {
+        for (const auto& documentPart : doc->parts()) {
+            numberImages(documentPart);
+        }
+    } else if (auto image = boost::get<document_part::Image>(&part)) {
+        numberImage(*image);
+    } else if (auto table = boost::get<document_part::Table>(&part)) {
+        for (const auto& row : table->cells) {
+            for (const auto& cell : row) {
+                if (cell.isHiddenBySpan) {
+                    continue;
+                }
+                for (const auto& cellPart : cell.content) {
+                    numberImages(cellPart);
+                }
+            }
+        }
+    }
+}
+
+void HtmlOutput::numberImage(const document_part::Image& image) {
+    const auto hash = hash::compute(image.data);
+
+    // the hash only preselects, the content decides
+    UniqueImage* unique = nullptr;
+    auto         range  = _uniqueImagesByHash.equal_range(hash);
+    for (auto candidate = range.first; candidate != range.second; candidate++) {
+        auto& other = _uniqueImages[candidate->second - 1];
+        if (other.image->data == image.data && other.image->format == image.format && other.image->fileExtension == image.fileExtension) {
+            unique = &other;
+            break;
+        }
+    }
+
+    if (unique == nullptr) {
+        _uniqueImages.push_back({&image, _imageCounter, 0, 0, 0});
+        _uniqueImagesByHash.emplace(hash, _imageCounter);
+        unique = &_uniqueImages.back();
+        _imageCounter++;
+
+        if (!_embedImages) {
+            const auto fileName = imageFileName(image, unique->number);
+            _writtenFiles.push_back(fileName);
+            writeImageFile(image, fileName);
+        }
+    }
+
+    unique->references++;
+    _imageNumbers[&image] = unique->number;
+}
+
+std::string HtmlOutput::imageFileName(const document_part::Image& image, unsigned int number) const {
+    return _nameBase + "_image_" + std::to_string(number) + "." + image.fileExtension;
+}
+
+void HtmlOutput::writeImageFile(const document_part::Image& image, const std::string& fileName) {
+    // the image data is owned by the document, which outlives writeBody
+    _imageWrites.push_back(imageWriterPool().submit([fileName, data = boost::string_view(image.data)]() { return writeFileIfChanged(fileName, data); }));
+}
+
+void HtmlOutput::waitForImageFiles() {
+    for (auto& write : _imageWrites) {
+        if (!write.get()) {
+            _writeFailed = true;
+        }
+    }
+    _imageWrites.clear();
+}
+
+void HtmlOutput::writeImageDefinitions(HtmlSink& body) {
+    // embedded images referenced more than once are defined once as svg symbol, every reference uses it,
+    // an svg needs a size, so images of unknown size are embedded at every reference instead
+    bool definitionsOpen = false;
+    for (auto& unique : _uniqueImages) {
+        if (unique.references < 2 || !imageSize(*unique.image, unique.width, unique.height)) {
+            continue;
+        }
+        if (!definitionsOpen) {
+            body << "<svg width=\"0\" height=\"0\" style=\"position:absolute\" aria-hidden=\"true\">\n";
+            definitionsOpen = true;
+        }
+
+        const auto width  = formatLength(unique.width);
+        const auto height = formatLength(unique.height);
+        body << "<symbol id=\"docmalaImage_" << unique.number << "\" viewBox=\"0 0 " << width << " " << height << "\">";
+        body << "<image width=\"" << width << "\" height=\"" << height << "\" href=\"data:image/";
+        writeEscaped(body, unique.image->format, Escape::Attribute);
+        body << ";base64,";
+        writeBase64(body, unique.image->data);
+        body << "\"/></symbol>\n";
+    }
+    if (definitionsOpen) {
+        body << "</svg>\n";
+    }
+}
+
+void HtmlOutput::writeDocumentParts(HtmlSink& outFile, const document_part::PartList& documentParts, bool isGenerated) {
+    writeDocumentParts(outFile, documentParts.begin(), documentParts.end(), isGenerated);
+}
+
+void HtmlOutput::writeText(HtmlSink& outFile, const document_part::Text& text, bool isGenerated) {
+    if (!isGenerated) {
+        outFile << "<span " << id(text) << ">";
+    }
+
+    writeDocumentParts(outFile, text.text, isGenerated);
+
+    if (!isGenerated) {
+        outFile << "</span>\n";
+    }
+}
+
+void HtmlOutput::writeDocumentParts(HtmlSink&                                outFile,
+                                    document_part::PartList::const_iterator begin,
+                                    document_part::PartList::const_iterator end,
+                                    bool                                     isGenerated) {
     bool paragraphOpen = false;
-    auto previous      = documentParts.end();
-    auto part          = documentParts.begin();
+    auto previous      = end;
+    auto part          = begin;
+
+    auto previousCaption = [&]() -> const document_part::Caption* {
+        if (previous == end) {
+            return nullptr;
+        }
+        return boost::get<document_part::Caption>(&*previous);
+    };
 
     auto visitor = make_visitor(
         // visitors
@@ -366,17 +751,7 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
                 }
             }
         },
-        [&](const document_part::Text& text) {
-            if (!isGenerated) {
-                outFile << "<span " << id(text) << ">";
-            }
-
-            writeDocumentParts(outFile, text.text, isGenerated);
-
-            if (!isGenerated) {
-                outFile << "</span>\n";
-            }
-        },
+        [&](const document_part::Text& text) { writeText(outFile, text, isGenerated); },
         [&](const document_part::Paragraph&) {
             if (paragraphOpen) {
                 outFile << "</p>\n";
@@ -387,33 +762,35 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
         },
         [&](const document_part::Image& image) {
             outFile << "<figure" << id(image) << ">\n";
-            if (_embedImages) {
-                outFile << "<img src=\"data:image/" << image.format << ";base64,";
-                outFile << base64_encode(image.data);
+            const auto  number = _imageNumbers.at(&image);
+            const auto& unique = _uniqueImages[number - 1];
+            if (_embedImages && unique.width > 0) {
+                const auto width  = formatLength(unique.width);
+                const auto height = formatLength(unique.height);
+                outFile << "<svg width=\"" << width << "\" height=\"" << height << "\" viewBox=\"0 0 " << width << " " << height << "\" role=\"img\">";
+                outFile << "<use href=\"#docmalaImage_" << number << "\"/></svg>";
+            } else if (_embedImages) {
+                outFile << "<img src=\"data:image/";
+                writeEscaped(outFile, image.format, Escape::Attribute);
+                outFile << ";base64,";
+                writeBase64(outFile, image.data);
                 outFile << "\">";
             } else {
-                std::ofstream     imgFile;
-                std::stringstream fileName;
-
-                fileName << _nameBase << "_image_" << _imageCounter << "." << image.fileExtension;
-
-                imgFile.open(fileName.str(), std::ofstream::binary | std::ofstream::out);
-                imgFile << image.data;
-                imgFile.close();
-
-                std::string imageImportName = fileName.str();
+                std::string imageImportName = imageFileName(image, number);
                 std::replace(imageImportName.begin(), imageImportName.end(), '\\', '/');
                 if (imageImportName.find_last_of('/') != std::string::npos) {
                     imageImportName = imageImportName.substr(imageImportName.find_last_of('/') + 1);
                 }
 
-                outFile << "<img src=\"" << imageImportName << "\">\n";
+                outFile << "<img src=\"";
+                writeEscaped(outFile, imageImportName, Escape::Attribute);
+                outFile << "\">\n";
             }
             auto title = _titleData.find(image.location);
             if (title != _titleData.end()) {
                 outFile << "<figcaption>" << title->second.id << ": ";
                 if (!isGenerated) {
-                    if (auto caption = boost::get<document_part::Caption>(&*previous)) {
+                    if (auto caption = previousCaption()) {
                         outFile << "<span " << id(*caption) << ">";
                     }
                 }
@@ -424,22 +801,21 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
                 outFile << "</figcaption>\n";
             }
             outFile << "</figure>\n";
-            _imageCounter++;
         },
         [&](const document_part::List& list) { writeList(outFile, list, isGenerated); },
         [&](const document_part::GeneratedDocument& doc) {
             outFile << "<div " << id(doc) << ">\n";
-            writeDocumentParts(outFile, doc.document, true);
+            writeDocumentParts(outFile, doc.parts(), true);
             outFile << "</div>\n";
         },
         [&](const document_part::Code& code) {
             outFile << "<figure" << id(code) << ">\n";
-            writeCode(outFile, code);
+            writeCode(outFile, code, _highlightCode);
             auto title = _titleData.find(code.location);
             if (title != _titleData.end()) {
                 outFile << "<figcaption>" << title->second.id << ": ";
                 if (!isGenerated) {
-                    if (auto caption = boost::get<document_part::Caption>(&*previous)) {
+                    if (auto caption = previousCaption()) {
                         outFile << "<span " << id(*caption) << ">";
                     }
                 }
@@ -452,7 +828,11 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
 
             outFile << "</figure>\n";
         },
-        [&](const document_part::Anchor& anchor) { outFile << "<a id=\"" << escapeAnchor(anchor.name) << "\"/>\n"; },
+        [&](const document_part::Anchor& anchor) {
+            outFile << "<a id=\"";
+            writeEscaped(outFile, escapeAnchor(anchor.name), Escape::Attribute);
+            outFile << "\"/>\n";
+        },
         [&](const document_part::Link& link) {
             std::string text = link.text;
             TitleData   titleData;
@@ -467,7 +847,9 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
             }
 
             if (link.type == document_part::Link::Type::IntraFile) {
-                outFile << "<a href=\"#" << escapeAnchor(link.data) << "\">";
+                outFile << "<a href=\"#";
+                writeEscaped(outFile, escapeAnchor(link.data), Escape::Attribute);
+                outFile << "\">";
                 if ((text == "#" || text == "#*") && !titleData.id.empty()) {
                     outFile << titleData.id;
                     if (text == "#*") {
@@ -481,15 +863,23 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
                 if (text == "*" || link.text == "#*" || titleData.id.empty()) {
                     writeDocumentParts(outFile, titleData.text.text, true);
                 } else if (text != "#") {
-                    outFile << text;
+                    writeEscaped(outFile, text);
                 }
                 outFile << "</a>\n";
             } else if (link.type == document_part::Link::Type::InterFile) {
                 std::string data     = link.data;
                 data[data.find(':')] = '#';
-                outFile << "<a href=\"" << data << "\">" << text << "</a>\n";
+                outFile << "<a href=\"";
+                writeEscaped(outFile, data, Escape::Attribute);
+                outFile << "\">";
+                writeEscaped(outFile, text);
+                outFile << "</a>\n";
             } else if (link.type == document_part::Link::Type::Web) {
-                outFile << "<a href=\"" << link.data << "\">" << text << "</a>\n";
+                outFile << "<a href=\"";
+                writeEscaped(outFile, link.data, Escape::Attribute);
+                outFile << "\">";
+                writeEscaped(outFile, text);
+                outFile << "</a>\n";
             }
         },
         [&](const document_part::Table& table) {
@@ -500,7 +890,7 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
                 outFile << "<figcaption>" << title->second.id << ": ";
 
                 if (!isGenerated) {
-                    if (auto caption = boost::get<document_part::Caption>(&*previous)) {
+                    if (auto caption = previousCaption()) {
                         outFile << "<span " << id(*caption) << ">";
                     }
                 }
@@ -515,7 +905,7 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
         },
         [](const auto&) {});
 
-    for (; part != documentParts.end(); part++) {
+    for (; part != end; part++) {
         boost::apply_visitor(visitor, *part);
         previous = part;
     }
@@ -526,93 +916,171 @@ void HtmlOutput::writeDocumentParts(std::stringstream& outFile, const std::vecto
     }
 }
 
-HtmlOutput::HtmlDocument HtmlOutput::produceHtml(const ParameterList& parameters, const Document& document, const std::string& scripts) {
-    std::string outputFileName = "outfile.html";
+void HtmlOutput::writeDocumentPartsParallel(HtmlSink& outFile, const document_part::PartList& documentParts) {
+    auto& pool = renderPool();
 
-    auto inputFile = parameters.find("inputFile");
+    // A chunk only starts with a paragraph or headline. The serial writer closes an open paragraph right before
+    // those, so closing it at the end of the previous chunk instead produces the same output.
+    const auto minimumChunkSize = std::max<std::ptrdiff_t>(16, static_cast<std::ptrdiff_t>(documentParts.size() / (4 * pool.workerCount())));
 
-    if (inputFile != parameters.end()) {
-        outputFileName = inputFile->second.value;
-        _nameBase      = outputFileName.substr(0, outputFileName.find_last_of('.'));
-        outputFileName = _nameBase + ".html";
+    std::vector<std::pair<document_part::PartList::const_iterator, document_part::PartList::const_iterator>> chunks;
+
+    auto chunkBegin = documentParts.begin();
+    for (auto part = documentParts.begin(); part != documentParts.end(); part++) {
+        const bool startsSection = boost::get<document_part::Paragraph>(&*part) != nullptr || boost::get<document_part::Headline>(&*part) != nullptr;
+        if (startsSection && part - chunkBegin >= minimumChunkSize) {
+            chunks.emplace_back(chunkBegin, part);
+            chunkBegin = part;
+        }
     }
+    chunks.emplace_back(chunkBegin, documentParts.end());
 
-    std::string pluginDir     = "./";
-    auto        pluginDirIter = parameters.find("pluginDir");
-    if (pluginDirIter != parameters.end()) {
-        pluginDir = pluginDirIter->second.value + '/';
+    if (chunks.size() == 1) {
+        writeDocumentParts(outFile, documentParts);
+        return;
     }
 
-    _embedImages = parameters.find("embedImages") != parameters.end();
+    std::vector<std::future<std::string>> rendered;
+    rendered.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        rendered.push_back(pool.submit([this, chunk]() {
+            std::string html;
+            {
+                StringSink sink(html);
+                writeDocumentParts(sink, chunk.first, chunk.second, false);
+            }
+            return html;
+        }));
+    }
 
-    std::string codeHighlightScript;
-    std::string codeHighlightCSS;
-    std::string generalCSS;
+    for (auto& chunk : rendered) {
+        outFile << chunk.get();
+    }
+}
 
-    std::ifstream highlightReader(pluginDir + "outputPluginHtmlCodeHighlight.js", std::ios::in | std::ios::binary);
-    if (highlightReader) {
-        highlightReader.seekg(0, std::ios::end);
-        codeHighlightScript.resize(static_cast<std::string::size_type>(highlightReader.tellg()));
-        highlightReader.seekg(0, std::ios::beg);
-        highlightReader.read(&codeHighlightScript[0], static_cast<std::streamsize>(codeHighlightScript.size()));
-        highlightReader.close();
+void HtmlOutput::setup(const ParameterList& parameters, const Document& document) {
+    auto inputFile = parameters.find("inputFile");
 
-        replaceAll(codeHighlightScript, "<script", "&lt;script");
-        replaceAll(codeHighlightScript, "</script", "&lt;/script");
+    if (inputFile != parameters.end()) {
+        const auto& outputFileName = inputFile->second.value;
+        _nameBase                  = outputFileName.substr(0, outputFileName.find_last_of('.'));
     }
 
-    std::ifstream codeHighlightReader(pluginDir + "outputPluginHtmlDefaultStyle.css", std::ios::in | std::ios::binary);
-    if (codeHighlightReader) {
-        codeHighlightReader.seekg(0, std::ios::end);
-        codeHighlightCSS.resize(static_cast<std::string::size_type>(codeHighlightReader.tellg()));
-        codeHighlightReader.seekg(0, std::ios::beg);
-        codeHighlightReader.read(&codeHighlightCSS[0], static_cast<std::streamsize>(codeHighlightCSS.size()));
-        codeHighlightReader.close();
+    _pluginDir         = "./";
+    auto pluginDirIter = parameters.find("pluginDir");
+    if (pluginDirIter != parameters.end()) {
+        _pluginDir = pluginDirIter->second.value + '/';
     }
 
-    std::ifstream generalCSSReader(pluginDir + "outputPluginHtmlCodeHighlight.css", std::ios::in | std::ios::binary);
-    if (generalCSSReader) {
-        generalCSSReader.seekg(0, std::ios::end);
-        generalCSS.resize(static_cast<std::string::size_type>(generalCSSReader.tellg()));
-        generalCSSReader.seekg(0, std::ios::beg);
-        generalCSSReader.read(&generalCSS[0], static_cast<std::streamsize>(generalCSS.size()));
-        generalCSSReader.close();
-    }
+    _embedImages    = parameters.find("embedImages") != parameters.end();
+    _parallelRender = parameters.find("parallelRender") != parameters.end();
+    _sharedAssets   = parameters.find("sharedAssets") != parameters.end();
+    _highlightCode  = parameters.find("highlightCode") != parameters.end();
 
-    HtmlDocument html;
+    // images are numbered per document, before the first part is written
+    _imageCounter = 1;
+    _imageNumbers.clear();
+    _uniqueImages.clear();
+    _uniqueImagesByHash.clear();
+    prepare(document.parts());
+}
 
-    std::stringstream head;
-    std::stringstream body;
+void HtmlOutput::writeHead(HtmlSink& head, const Document& document, const std::string& scripts) {
+    const auto& assets = staticAssets(_pluginDir);
 
     head << "<meta charset=\"utf-8\">\n";
     if (document.metaData().find("title") != document.metaData().end()) {
-        head << "<title>" + document.metaData().at("title").data.front().value + "</title>\n";
+        head << "<title>";
+        writeEscaped(head, document.metaData().at("title").data.front().value);
+        head << "</title>\n";
     } else {
         head << "<title>[No title]</title>\n";
     }
 
-    head << "<style>\n";
-    head << codeHighlightCSS << "\n";
-    head << generalCSS << "\n";
-    head << "</style>\n";
+    if (_sharedAssets) {
+        const auto directory = _nameBase.substr(0, _nameBase.find_last_of("\\/") + 1);
+        std::vector<const StaticAssets::Asset*> shared = {&assets.defaultStyle, &assets.codeHighlightStyle};
+        if (!_highlightCode) {
+            shared.push_back(&assets.codeHighlightScript);
+        }
+        for (const auto* asset : shared) {
+            if (writeSharedAsset(directory, *asset)) {
+                _writtenFiles.push_back(directory + asset->sharedFileName);
+            } else {
+                _writeFailed = true;
+            }
+        }
+
+        head << "<link rel=\"stylesheet\" href=\"" << assets.defaultStyle.sharedFileName << "\">\n";
+        head << "<link rel=\"stylesheet\" href=\"" << assets.codeHighlightStyle.sharedFileName << "\">\n";
+    } else {
+        head << "<style>\n";
+        head << assets.defaultStyle.content << "\n";
+        head << assets.codeHighlightStyle.content << "\n";
+        head << "</style>\n";
+    }
 
     head << "<script>\n";
     head << scripts << "\n";
     head << "</script>\n";
-    head << "<script>\n";
-    head << codeHighlightScript << "\n";
-    head << "</script>\n";
+    if (_highlightCode) {
+        return;
+    }
+    if (_sharedAssets) {
+        head << "<script src=\"" << assets.codeHighlightScript.sharedFileName << "\"></script>\n";
+    } else {
+        head << "<script>\n";
+        head << assets.inlineCodeHighlightScript << "\n";
+        head << "</script>\n";
+    }
     head << "<script>hljs.initHighlightingOnLoad();</script>\n";
+}
 
-    prepare(document.parts());
-    writeDocumentParts(body, document.parts());
+void HtmlOutput::writeBody(HtmlSink& body, const Document& document) {
+    if (_embedImages) {
+        writeImageDefinitions(body);
+    }
 
-    html.head = head.str();
-    html.body = body.str();
-    return html;
+    if (_parallelRender) {
+        writeDocumentPartsParallel(body, document.parts());
+    } else {
+        writeDocumentParts(body, document.parts());
+    }
+
+    waitForImageFiles();
 }
 
+HtmlOutput::HtmlDocument HtmlOutput::produceHtml(const ParameterList& parameters, const Document& document, const std::string& scripts) {
+    setup(parameters, document);
 
+    HtmlDocument html;
+    {
+        StringSink head(html.head);
+        writeHead(head, document, scripts);
+    }
+    {
+        StringSink body(html.body);
+        writeBody(body, document);
+    }
+    return html;
+}
+
+void HtmlOutput::writeHtml(const ParameterList& parameters, const Document& document, HtmlSink& sink, const std::string& scripts) {
+    setup(parameters, document);
+
+    sink << "<!doctype html>\n";
+    sink << "<html>\n";
+    sink << "<head>\n";
+    writeHead(sink, document, scripts);
+    sink << "\n";
+    sink << "</head>\n";
+
+    sink << "<body>\n";
+    writeBody(sink, document);
+    sink << "\n";
+    sink << "</body>\n";
+    sink.flush();
+}
 
 bool HtmlOutputPlugin::write(const ParameterList &parameters, const Document &document) {
     std::string nameBase       = "outfile";
@@ -626,26 +1094,26 @@ bool HtmlOutputPlugin::write(const ParameterList &parameters, const Document &do
         outputFileName = nameBase + ".html";
     }
 
-    std::ofstream outFile;
+    _outputFiles.clear();
 
-    outFile.open(outputFileName);
+    FileSink outFile(outputFileName);
 
-    if (outFile.is_open()) {
+    if (outFile.isOpen()) {
         HtmlOutput output;
-        auto       html = output.produceHtml(parameters, document);
-
-        outFile << "<!doctype html>\n";
-        outFile << "<html>\n";
-        outFile << "<head>\n";
-        outFile << html.head << "\n";
-        outFile << "</head>\n";
+        output.writeHtml(parameters, document, outFile);
+        if (!outFile.close() || output.writeFailed()) {
+            return false;
+        }
 
-        outFile << "<body>\n";
-        outFile << html.body << "\n";
-        outFile << "</body>\n";
+        _outputFiles = output.writtenFiles();
+        _outputFiles.push_back(outputFileName);
         return true;
     }
     return false;
 }
 
+std::vector<std::string> HtmlOutputPlugin::outputFiles() const {
+    return _outputFiles;
+}
+
 EXTENSION_SYSTEM_EXTENSION(docmala::OutputPlugin, HtmlOutputPlugin, "html", 1, "Write document to a HTML file", EXTENSION_SYSTEM_NO_USER_DATA)
@@ -23,11 +23,15 @@
 #include "HtmlOutput_global.h"
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <future>
 #include <map>
+#include <unordered_map>
 #include <docmala/Document.h>
 #include <docmala/Parameter.h>
 
 namespace docmala {
+class HtmlSink;
 
 class HTMLOUTPUT_API HtmlOutput {
     // OutputPlugin interface
@@ -39,14 +43,50 @@ public:
 
     HtmlDocument produceHtml(const ParameterList& parameters, const Document& document, const std::string& scripts = "");
 
+    /**
+     * @brief Writes the complete HTML file to sink. In contrast to produceHtml, the document is streamed
+     *        and never held in memory as a whole.
+     */
+    void writeHtml(const ParameterList& parameters, const Document& document, HtmlSink& sink, const std::string& scripts = "");
+
+    /**
+     * @brief Image and shared asset files written by produceHtml
+     */
+    const std::vector<std::string>& writtenFiles() const {
+        return _writtenFiles;
+    }
+
+    /**
+     * @brief True, if one of the image or shared asset files could not be written
+     */
+    bool writeFailed() const {
+        return _writeFailed;
+    }
+
 private:
-    void prepare(const std::vector<document_part::Variant>& documentParts);
+    void setup(const ParameterList& parameters, const Document& document);
+    void writeHead(HtmlSink& head, const Document& document, const std::string& scripts);
+    void writeBody(HtmlSink& body, const Document& document);
+
+    void prepare(const document_part::PartList& documentParts);
+    void numberImages(const document_part::Variant& part);
+    void numberImage(const document_part::Image& image);
+    std::string imageFileName(const document_part::Image& image, unsigned int number) const;
+    void        writeImageFile(const document_part::Image& image, const std::string& fileName);
+    void        waitForImageFiles();
+    void        writeImageDefinitions(HtmlSink& body);
 
-    void writeDocumentParts(std::stringstream& outFile, const std::vector<document_part::Variant>& documentParts, bool isGenerated = false);
+    void writeDocumentParts(HtmlSink& outFile, const document_part::PartList& documentParts, bool isGenerated = false);
+    void writeDocumentParts(HtmlSink&                                outFile,
+                            document_part::PartList::const_iterator begin,
+                            document_part::PartList::const_iterator end,
+                            bool                                     isGenerated);
+    void writeDocumentPartsParallel(HtmlSink& outFile, const document_part::PartList& documentParts);
+    void writeText(HtmlSink& outFile, const document_part::Text& text, bool isGenerated);
 
-    void writeTable(std::stringstream& outFile, const document_part::Table& table);
-    void writeList(std::stringstream& outFile, const document_part::List& list, bool isGenerated);
-    void writeListEntries(std::stringstream& outFile, const std::vector<document_part::List::Entry>& entries, bool isGenerated);
+    void writeTable(HtmlSink& outFile, const document_part::Table& table);
+    void writeList(HtmlSink& outFile, const document_part::List& list, bool isGenerated);
+    void writeListEntries(HtmlSink& outFile, const document_part::Vector<document_part::List::Entry>& entries, bool isGenerated);
 
     unsigned int         _imageCounter                       = 1;
     unsigned int         _figureCounter                      = 1;
@@ -55,15 +95,40 @@ private:
     static constexpr int _maxHeadlineLevels                  = 32;
     int                  _headlineLevels[_maxHeadlineLevels] = {0};
 
-    std::string _nameBase    = "outfile";
-    bool        _embedImages = false;
+    std::string              _nameBase       = "outfile";
+    std::string              _pluginDir      = "./";
+    bool                     _embedImages    = false;
+    bool                     _parallelRender = false;
+    bool                     _sharedAssets   = false;
+    bool                     _highlightCode  = false;
+    std::vector<std::string> _writtenFiles;
+
+    /**
+     * @brief Images with the same content share one number, so one file or one embedded copy.
+     */
+    struct UniqueImage {
+        const document_part::Image* image      = nullptr;
+        unsigned int                number     = 0;
+        unsigned int                references = 0;
+        double                      width      = 0; ///< set, if the embedded image is defined once and used by reference
+        double                      height     = 0;
+    };
+
+    // numbers assigned in document order by prepare, so parts can be rendered independently of each other
+    std::unordered_map<const document_part::Image*, unsigned int> _imageNumbers;
+    std::vector<UniqueImage>                                      _uniqueImages;
+    std::unordered_multimap<std::uint64_t, unsigned int>          _uniqueImagesByHash;
+
+    // image files are written in the background while rendering, the writes are waited for at the end of writeBody
+    std::vector<std::future<bool>> _imageWrites;
+    bool                           _writeFailed = false;
 
     struct TitleData {
         std::string        id;
         document_part::Text text;
     };
 
-    std::map<std::string, TitleData>  _anchorData;
-    std::map<FileLocation, TitleData> _titleData;
+    std::map<std::string, TitleData>            _anchorData;
+    std::unordered_map<FileLocation, TitleData> _titleData;
 };
 }
@@ -0,0 +1,120 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "HtmlSink.h"
+
+#include <docmala/Scanner.h>
+
+using namespace docmala;
+
+namespace {
+struct EntityTable {
+    EntityTable() {
+        entities[static_cast<unsigned char>('<')] = "&lt;";
+        entities[static_cast<unsigned char>('>')] = "&gt;";
+        entities[static_cast<unsigned char>('&')] = "&amp;";
+        entities[static_cast<unsigned char>('"')] = "&quot;";
+    }
+
+    const char* entities[256] = {nullptr};
+};
+} // namespace
+
+HtmlSink::HtmlSink(std::size_t bufferSize)
+    : _buffer(bufferSize) {}
+
+HtmlSink::~HtmlSink() = default;
+
+void HtmlSink::flush() {
+    if (_used > 0) {
+        flushBuffer(_buffer.data(), _used);
+        _used = 0;
+    }
+}
+
+StringSink::StringSink(std::string& target)
+    : HtmlSink(16 * 1024)
+    , _target(target) {}
+
+StringSink::~StringSink() {
+    flush();
+}
+
+void StringSink::flushBuffer(const char* data, std::size_t size) {
+    _target.append(data, size);
+}
+
+StreamSink::StreamSink(std::ostream& target)
+    : _target(target) {}
+
+StreamSink::~StreamSink() {
+    flush();
+}
+
+void StreamSink::flushBuffer(const char* data, std::size_t size) {
+    _target.write(data, static_cast<std::streamsize>(size));
+}
+
+FileSink::FileSink(const std::string& fileName)
+    : _file(std::fopen(fileName.c_str(), "w")) {
+    if (_file != nullptr) {
+        std::setvbuf(_file, nullptr, _IONBF, 0);
+    }
+}
+
+FileSink::~FileSink() {
+    close();
+}
+
+bool FileSink::close() {
+    if (_file != nullptr) {
+        flush();
+        _ok   = std::fclose(_file) == 0 && _ok;
+        _file = nullptr;
+    }
+    return _ok;
+}
+
+void FileSink::flushBuffer(const char* data, std::size_t size) {
+    if (_file != nullptr && std::fwrite(data, 1, size, _file) != size) {
+        _ok = false;
+    }
+}
+
+// runs without special characters are copied as a whole
+void docmala::writeEscaped(HtmlSink& sink, boost::string_view text, Escape context) {
+    static const EntityTable           table;
+    static const scanner::CharacterSet textCharacters("<>&");
+    static const scanner::CharacterSet attributeCharacters("<>&\"");
+
+    const auto& special  = context == Escape::Attribute ? attributeCharacters : textCharacters;
+    const char* position = text.data();
+    const char* end      = text.data() + text.size();
+
+    while (position != end) {
+        const char* next = scanner::findFirstOf(position, end, special);
+        sink.write(position, static_cast<std::size_t>(next - position));
+        if (next == end) {
+            break;
+        }
+        sink << table.entities[static_cast<unsigned char>(*next)];
+        position = next + 1;
+    }
+}
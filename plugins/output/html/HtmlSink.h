@@ -0,0 +1,170 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "HtmlOutput_global.h"
+#include <algorithm>
+#include <boost/utility/string_view.hpp>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace docmala {
+
+/**
+ * @brief Target of the HTML writer. Output is collected in a buffer and handed on in large chunks,
+ *        so the memory needed while writing does not depend on the size of the document.
+ */
+class HTMLOUTPUT_API HtmlSink {
+public:
+    explicit HtmlSink(std::size_t bufferSize = 256 * 1024);
+    virtual ~HtmlSink();
+
+    HtmlSink(const HtmlSink&) = delete;
+    HtmlSink& operator=(const HtmlSink&) = delete;
+
+    void write(const char* data, std::size_t size) {
+        if (size > _buffer.size() - _used) {
+            flush();
+            if (size >= _buffer.size()) {
+                // large blocks bypass the buffer
+                flushBuffer(data, size);
+                return;
+            }
+        }
+        std::copy(data, data + size, _buffer.data() + _used);
+        _used += size;
+    }
+
+    HtmlSink& operator<<(boost::string_view text) {
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    HtmlSink& operator<<(char c) {
+        write(&c, 1);
+        return *this;
+    }
+
+    HtmlSink& operator<<(int value) {
+        return *this << std::to_string(value);
+    }
+
+    HtmlSink& operator<<(unsigned int value) {
+        return *this << std::to_string(value);
+    }
+
+    /**
+     * @brief Returns a buffer of at least size bytes, that is appended by commit. size must not exceed the buffer size.
+     *        Allows producers like encoders to write into the sink without an intermediate copy.
+     */
+    char* reserve(std::size_t size) {
+        if (size > _buffer.size() - _used) {
+            flush();
+        }
+        return _buffer.data() + _used;
+    }
+
+    void commit(std::size_t size) {
+        _used += size;
+    }
+
+    std::size_t bufferSize() const {
+        return _buffer.size();
+    }
+
+    void flush();
+
+protected:
+    virtual void flushBuffer(const char* data, std::size_t size) = 0;
+
+private:
+    std::vector<char> _buffer;
+    std::size_t       _used = 0;
+};
+
+/**
+ * @brief Appends to a string.
+ */
+class HTMLOUTPUT_API StringSink : public HtmlSink {
+public:
+    explicit StringSink(std::string& target);
+    ~StringSink() override;
+
+protected:
+    void flushBuffer(const char* data, std::size_t size) override;
+
+private:
+    std::string& _target;
+};
+
+/**
+ * @brief Writes to a std::ostream.
+ */
+class HTMLOUTPUT_API StreamSink : public HtmlSink {
+public:
+    explicit StreamSink(std::ostream& target);
+    ~StreamSink() override;
+
+protected:
+    void flushBuffer(const char* data, std::size_t size) override;
+
+private:
+    std::ostream& _target;
+};
+
+/**
+ * @brief Writes to a file, bypassing the buffering of the C library.
+ */
+class HTMLOUTPUT_API FileSink : public HtmlSink {
+public:
+    explicit FileSink(const std::string& fileName);
+    ~FileSink() override;
+
+    bool isOpen() const {
+        return _file != nullptr;
+    }
+
+    /**
+     * @brief Returns false, if writing failed at any point.
+     */
+    bool close();
+
+protected:
+    void flushBuffer(const char* data, std::size_t size) override;
+
+private:
+    std::FILE* _file = nullptr;
+    bool       _ok   = true;
+};
+
+enum class Escape {
+    Text, ///< element content, escapes '<', '>' and '&'
+    Attribute ///< quoted attribute values, additionally escapes '"'
+};
+
+/**
+ * @brief Writes text with the characters special in context replaced by entities, in a single pass.
+ */
+HTMLOUTPUT_API void writeEscaped(HtmlSink& sink, boost::string_view text, Escape context = Escape::Text);
+
+} // namespace docmala
@@ -0,0 +1,111 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <docmala/Base64.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace docmala;
+
+namespace {
+/**
+ * @brief Straightforward scalar encoder, the vectorized ones have to produce the same output.
+ */
+std::string encodeReference(const std::vector<unsigned char>& input) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    size_t      i = 0;
+    for (; i + 3 <= input.size(); i += 3) {
+        const unsigned value = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+        result += alphabet[(value >> 18) & 0x3f];
+        result += alphabet[(value >> 12) & 0x3f];
+        result += alphabet[(value >> 6) & 0x3f];
+        result += alphabet[value & 0x3f];
+    }
+    if (input.size() - i == 1) {
+        const unsigned value = input[i] << 16;
+        result += alphabet[(value >> 18) & 0x3f];
+        result += alphabet[(value >> 12) & 0x3f];
+        result += "==";
+    } else if (input.size() - i == 2) {
+        const unsigned value = (input[i] << 16) | (input[i + 1] << 8);
+        result += alphabet[(value >> 18) & 0x3f];
+        result += alphabet[(value >> 12) & 0x3f];
+        result += alphabet[(value >> 6) & 0x3f];
+        result += '=';
+    }
+    return result;
+}
+
+std::string encode(const unsigned char* input, size_t size) {
+    // the guard detects writes beyond encodedSize
+    const char  guard = '#';
+    std::string output(base64::encodedSize(size) + 1, guard);
+
+    const auto written = base64::encode(input, size, &output[0]);
+    CHECK(written == base64::encodedSize(size));
+    CHECK(output.back() == guard);
+    output.pop_back();
+    return output;
+}
+
+std::string encode(const std::string& input) {
+    return encode(reinterpret_cast<const unsigned char*>(input.data()), input.size());
+}
+} // namespace
+
+TEST_CASE("base64::encode produces the test vectors of RFC 4648") {
+    CHECK(encode("") == "");
+    CHECK(encode("f") == "Zg==");
+    CHECK(encode("fo") == "Zm8=");
+    CHECK(encode("foo") == "Zm9v");
+    CHECK(encode("foob") == "Zm9vYg==");
+    CHECK(encode("fooba") == "Zm9vYmE=");
+    CHECK(encode("foobar") == "Zm9vYmFy");
+}
+
+TEST_CASE("base64::encode matches the scalar encoder") {
+    std::mt19937                       random(11);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // every length up to several blocks of the vectorized encoders, from unaligned input
+    for (size_t size = 0; size <= 300; size++) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            std::vector<unsigned char> buffer(offset + size);
+            for (auto& value : buffer) {
+                value = static_cast<unsigned char>(byte(random));
+            }
+            const std::vector<unsigned char> input(buffer.begin() + static_cast<std::ptrdiff_t>(offset), buffer.end());
+
+            INFO("size " << size << ", offset " << offset);
+            CHECK(encode(buffer.data() + offset, size) == encodeReference(input));
+        }
+    }
+
+    std::vector<unsigned char> large(1 << 20);
+    for (auto& value : large) {
+        value = static_cast<unsigned char>(byte(random));
+    }
+    CHECK(encode(large.data(), large.size()) == encodeReference(large));
+}
@@ -0,0 +1,170 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <boost/filesystem.hpp>
+#include <docmala/BuildCache.h>
+#include <docmala/Docmala.h>
+#include <docmala/Hash.h>
+#include <fstream>
+#include <string>
+
+using namespace docmala;
+namespace fs = boost::filesystem;
+
+namespace {
+/**
+ * @brief Directory for the files of one test, removed at the end of the test.
+ */
+class TemporaryDirectory {
+public:
+    TemporaryDirectory()
+        : _path(fs::temp_directory_path() / fs::unique_path("docmala_test_%%%%-%%%%-%%%%")) {
+        fs::create_directories(_path);
+    }
+
+    ~TemporaryDirectory() {
+        boost::system::error_code error;
+        fs::remove_all(_path, error);
+    }
+
+    std::string file(const std::string& name) const {
+        return (_path / name).string();
+    }
+
+private:
+    fs::path _path;
+};
+
+void writeFile(const std::string& fileName, const std::string& content) {
+    std::ofstream(fileName, std::ios::out | std::ios::binary | std::ios::trunc) << content;
+}
+
+std::uint64_t contentHash(const std::string& content) {
+    return hash::compute(content);
+}
+} // namespace
+
+TEST_CASE("hash::computeForFile equals the hash of the content") {
+    TemporaryDirectory directory;
+    const auto         fileName = directory.file("data.bin");
+
+    // sizes around the chunk size of the streamed read
+    for (size_t size : {0, 1, 7, 8, 9, 65535, 65536, 65537, 200003}) {
+        std::string content(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            content[i] = static_cast<char>(i * 31 + 7);
+        }
+        writeFile(fileName, content);
+
+        std::uint64_t result = 0;
+        INFO("size " << size);
+        REQUIRE(hash::computeForFile(fileName, result));
+        CHECK(result == contentHash(content));
+    }
+
+    std::uint64_t result = 0;
+    CHECK_FALSE(hash::computeForFile(directory.file("missing.bin"), result));
+}
+
+TEST_CASE("BuildCache detects changed inputs") {
+    TemporaryDirectory directory;
+    const BuildCache   cache(directory.file("cache"));
+
+    const auto input         = directory.file("input.dml");
+    const auto image         = directory.file("image.png");
+    const auto output        = directory.file("input.html");
+    const auto configuration = std::string("parameter a=b\n");
+
+    writeFile(input, "= Title\n");
+    writeFile(image, "png");
+    writeFile(output, "<html>");
+
+    const std::set<std::string>                dependencies = {input, image};
+    const std::map<std::string, std::uint64_t> hashes       = {{input, contentHash("= Title\n")}, {image, contentHash("png")}};
+
+    CHECK_FALSE(cache.isUpToDate(input, configuration));
+    REQUIRE(cache.store(input, configuration, dependencies, hashes, {output}));
+
+    SECTION("unchanged") {
+        std::set<std::string> recorded;
+        CHECK(cache.isUpToDate(input, configuration, &recorded));
+        CHECK(recorded == dependencies);
+    }
+
+    SECTION("changed dependency") {
+        writeFile(image, "png2");
+        CHECK_FALSE(cache.isUpToDate(input, configuration));
+    }
+
+    SECTION("changed configuration") {
+        CHECK_FALSE(cache.isUpToDate(input, "parameter a=c\n"));
+    }
+
+    SECTION("missing output") {
+        fs::remove(output);
+        CHECK_FALSE(cache.isUpToDate(input, configuration));
+    }
+
+    SECTION("invalidated") {
+        cache.invalidate(input);
+        CHECK_FALSE(cache.isUpToDate(input, configuration));
+    }
+}
+
+TEST_CASE("BuildCache records the content, that was read") {
+    TemporaryDirectory directory;
+    const BuildCache   cache(directory.file("cache"));
+
+    const auto input  = directory.file("input.dml");
+    const auto output = directory.file("input.html");
+    writeFile(output, "<html>");
+
+    SECTION("a file changed during the build is built again") {
+        writeFile(input, "changed while building");
+        REQUIRE(cache.store(input, "", {input}, {{input, contentHash("= Title\n")}}, {output}));
+        CHECK_FALSE(cache.isUpToDate(input, ""));
+    }
+
+    SECTION("a dependency without hash is recorded as missing") {
+        const auto missing = directory.file("missing.dml");
+        writeFile(input, "= Title\n");
+        REQUIRE(cache.store(input, "", {input, missing}, {{input, contentHash("= Title\n")}}, {output}));
+        CHECK(cache.isUpToDate(input, ""));
+
+        writeFile(missing, "created later");
+        CHECK_FALSE(cache.isUpToDate(input, ""));
+    }
+}
+
+TEST_CASE("Docmala records the hash of the parsed input") {
+    TemporaryDirectory directory;
+    const auto         input   = directory.file("input.dml");
+    const std::string  content = "= Title\r\n\nSome text\n";
+    writeFile(input, content);
+
+    Docmala docmala;
+    docmala.parseFile(input);
+
+    const auto& hashes = docmala.document().dependencyHashes();
+    REQUIRE(hashes.count(input) == 1);
+    CHECK(hashes.at(input) == contentHash(content));
+}
@@ -0,0 +1,132 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include "CodeHighlighter.h"
+#include "HtmlSink.h"
+#include <string>
+
+using namespace docmala;
+
+namespace {
+std::string highlight(const std::string& language, const std::string& code) {
+    std::string result;
+    {
+        StringSink sink(result);
+        REQUIRE(highlighter::write(sink, language, code));
+        sink.flush();
+    }
+    return result;
+}
+
+std::string span(const std::string& className, const std::string& text) {
+    return "<span class=\"hljs-" + className + "\">" + text + "</span>";
+}
+} // namespace
+
+TEST_CASE("highlighter supports cpp, python, json and shell") {
+    for (const char* language : {"cpp", "C++", "hpp", "python", "py", "json", "bash", "sh", "shell"}) {
+        INFO(language);
+        CHECK(highlighter::isSupported(language));
+    }
+
+    std::string result;
+    StringSink  sink(result);
+    CHECK_FALSE(highlighter::isSupported("cobol"));
+    CHECK_FALSE(highlighter::write(sink, "cobol", "MOVE A TO B."));
+    sink.flush();
+    CHECK(result.empty());
+}
+
+TEST_CASE("highlighter classes cpp tokens") {
+    CHECK(highlight("cpp", "int x = 0x1F + 1'000 + 2.5e-3;")
+          == span("keyword", "int") + " x = " + span("number", "0x1F") + " + " + span("number", "1'000") + " + " + span("number", "2.5e-3") + ";");
+
+    CHECK(highlight("cpp", "return nullptr; // done")
+          == span("keyword", "return") + " " + span("literal", "nullptr") + "; " + span("comment", "// done"));
+
+    CHECK(highlight("cpp", "std::string s;") == span("built_in", "std") + "::" + span("built_in", "string") + " s;");
+
+    // identifiers containing keywords are no keywords
+    CHECK(highlight("cpp", "integer if_ classic") == "integer if_ classic");
+}
+
+TEST_CASE("highlighter handles cpp strings and escapes") {
+    // quotes need no escaping in element content
+    CHECK(highlight("cpp", "\"a \\\"quoted\\\" <b>\"") == span("string", "\"a \\\"quoted\\\" &lt;b&gt;\""));
+    CHECK(highlight("cpp", "'\\'' + 'a'") == span("string", "'\\''") + " + " + span("string", "'a'"));
+
+    // raw strings end at their delimiter only
+    CHECK(highlight("cpp", "R\"x(a \")\" b)x\";") == span("string", "R\"x(a \")\" b)x\"") + ";");
+    CHECK(highlight("cpp", "u8R\"(\\)\" x") == span("string", "u8R\"(\\)\"") + " x");
+}
+
+TEST_CASE("highlighter handles cpp comments and directives") {
+    CHECK(highlight("cpp", "a /* b /* c */ d */") == "a " + span("comment", "/* b /* c */") + " d */");
+    CHECK(highlight("cpp", "#include <map>\nint") == span("meta", "#include &lt;map&gt;") + "\n" + span("keyword", "int"));
+    CHECK(highlight("cpp", "  #define A \\\n  1\nB") == "  " + span("meta", "#define A \\\n  1") + "\nB");
+    // '#' in the middle of a line is no directive
+    CHECK(highlight("cpp", "a # b") == "a # b");
+}
+
+TEST_CASE("highlighter stops unterminated cpp tokens") {
+    // strings end at the end of the line
+    CHECK(highlight("cpp", "\"open\nint") == span("string", "\"open") + "\n" + span("keyword", "int"));
+    CHECK(highlight("cpp", "x = \"open") == "x = " + span("string", "\"open"));
+    CHECK(highlight("cpp", "\"ends with backslash\\") == span("string", "\"ends with backslash\\"));
+    // comments and raw strings run to the end of the input
+    CHECK(highlight("cpp", "a /* open\nint") == "a " + span("comment", "/* open\nint"));
+    CHECK(highlight("cpp", "R\"(open\nint") == span("string", "R\"(open\nint"));
+    CHECK(highlight("cpp", "a /") == "a /");
+}
+
+TEST_CASE("highlighter classes python tokens") {
+    CHECK(highlight("python", "def f(x):  # add\n    return x + 1")
+          == span("keyword", "def") + " f(x):  " + span("comment", "# add") + "\n    " + span("keyword", "return") + " x + " + span("number", "1"));
+    CHECK(highlight("python", "print(None, True)") == span("built_in", "print") + "(" + span("literal", "None") + ", " + span("literal", "True") + ")");
+    CHECK(highlight("python", "s = '''a\n\"b\"\n'''") == "s = " + span("string", "'''a\n\"b\"\n'''"));
+    CHECK(highlight("python", "s = \"\"\"open\nx") == "s = " + span("string", "\"\"\"open\nx"));
+    CHECK(highlight("python", "'it\\'s' # c") == span("string", "'it\\'s'") + " " + span("comment", "# c"));
+}
+
+TEST_CASE("highlighter classes json tokens") {
+    CHECK(highlight("json", "{\"key\" : \"value\", \"n\": -1.5e3, \"b\": [true, null]}")
+          == "{" + span("attr", "\"key\"") + " : " + span("string", "\"value\"") + ", " + span("attr", "\"n\"") + ": -" + span("number", "1.5e3")
+                 + ", " + span("attr", "\"b\"") + ": [" + span("literal", "true") + ", " + span("literal", "null") + "]}");
+    CHECK(highlight("json", "{\"a&b\": \"<\\\"x\\\">\"}") == "{" + span("attr", "\"a&amp;b\"") + ": " + span("string", "\"&lt;\\\"x\\\"&gt;\"") + "}");
+    CHECK(highlight("json", "[\"open") == "[" + span("string", "\"open"));
+}
+
+TEST_CASE("highlighter classes shell tokens") {
+    CHECK(highlight("bash", "if [ -n \"$HOME\" ]; then echo ${PATH} $1; fi")
+          == span("keyword", "if") + " [ -n " + span("string", "\"$HOME\"") + " ]; " + span("keyword", "then") + " " + span("built_in", "echo") + " "
+                 + span("variable", "${PATH}") + " " + span("variable", "$1") + "; " + span("keyword", "fi"));
+
+    // '#' starts a comment only at the beginning of a word
+    CHECK(highlight("bash", "echo a#b # comment\n# line") == span("built_in", "echo") + " a#b " + span("comment", "# comment") + "\n" + span("comment", "# line"));
+
+    // single quotes have no escapes, double quotes may span lines
+    CHECK(highlight("bash", "echo 'a\\' b") == span("built_in", "echo") + " " + span("string", "'a\\'") + " b");
+    CHECK(highlight("bash", "x=\"a\nb\" && y") == "x=" + span("string", "\"a\nb\"") + " &amp;&amp; y");
+    CHECK(highlight("bash", "echo \"open\nstill open") == span("built_in", "echo") + " " + span("string", "\"open\nstill open"));
+    CHECK(highlight("bash", "x=${open") == "x=" + span("variable", "${open"));
+    CHECK(highlight("bash", "cost $ 5") == "cost $ " + span("number", "5"));
+}
@@ -0,0 +1,50 @@
+# Renders one document of testData to html and compares the output with the expected files.
+# PlantUML diagrams are left out, the PATH of docma does not contain java.
+#
+# DOCMA       docma executable, the plugins are expected next to it
+# TEST_DATA   directory with the documents and their images
+# NAME        document to render, without extension
+# PARAMETERS  optional parameters of the html output, separated by ','
+# EXPECTED    expected html file
+# IMAGES      optional written images and the files of TEST_DATA they have to match, e.g. "a_image_1.png:a.png,..."
+# WORK_DIR    directory the document is rendered in
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(GLOB inputs "${TEST_DATA}/*.dml" "${TEST_DATA}/*.png" "${TEST_DATA}/*.svg")
+file(COPY ${inputs} DESTINATION "${WORK_DIR}")
+
+set(arguments -i "${WORK_DIR}/${NAME}.dml" -p html)
+if(PARAMETERS)
+    string(REPLACE "," ";" parameters "${PARAMETERS}")
+    list(APPEND arguments --parameters ${parameters})
+endif()
+
+set(ENV{PATH} "${WORK_DIR}")
+get_filename_component(binaryDir "${DOCMA}" DIRECTORY)
+execute_process(COMMAND "${DOCMA}" ${arguments}
+                WORKING_DIRECTORY "${binaryDir}"
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output
+                ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "docma failed (${result}):\n${output}")
+endif()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${NAME}.html" "${EXPECTED}" RESULT_VARIABLE different)
+if(different)
+    message(FATAL_ERROR "${WORK_DIR}/${NAME}.html differs from ${EXPECTED}")
+endif()
+
+if(IMAGES)
+    string(REPLACE "," ";" images "${IMAGES}")
+    foreach(image IN LISTS images)
+        string(REPLACE ":" ";" files "${image}")
+        list(GET files 0 written)
+        list(GET files 1 original)
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${written}" "${TEST_DATA}/${original}" RESULT_VARIABLE different)
+        if(different)
+            message(FATAL_ERROR "${WORK_DIR}/${written} differs from ${TEST_DATA}/${original}")
+        endif()
+    endforeach()
+endif()
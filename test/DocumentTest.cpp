@@ -0,0 +1,63 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <docmala/Document.h>
+
+using namespace docmala;
+
+namespace {
+MetaData metaData(const std::string& key, MetaData::Mode mode, const std::string& value, int line) {
+    MetaData result;
+    result.key  = key;
+    result.mode = mode;
+    result.data.push_back({FileLocation(line, 0, "test.dml"), value});
+    return result;
+}
+} // namespace
+
+TEST_CASE("Document::mergeFrom adds meta data like addMetaData") {
+    Document document;
+    document.addMetaData(metaData("author", MetaData::Mode::List, "a", 1));
+    document.addMetaData(metaData("title", MetaData::Mode::First, "first", 2));
+
+    Document deferred;
+    deferred.addMetaData(metaData("author", MetaData::Mode::List, "b", 3));
+    deferred.addMetaData(metaData("author", MetaData::Mode::List, "c", 4));
+    deferred.addMetaData(metaData("title", MetaData::Mode::First, "second", 5));
+    deferred.addMetaData(metaData("toc", MetaData::Mode::Flag, "", 6));
+
+    document.mergeFrom(deferred);
+
+    const auto& merged = document.metaData();
+    REQUIRE(merged.at("author").data.size() == 3);
+    CHECK(merged.at("author").data[0].value == "a");
+    CHECK(merged.at("author").data[1].value == "b");
+    CHECK(merged.at("author").data[2].value == "c");
+    CHECK(merged.at("author").firstLocation == FileLocation(1, 0, "test.dml"));
+
+    REQUIRE(merged.at("title").data.size() == 1);
+    CHECK(merged.at("title").data[0].value == "first");
+
+    REQUIRE(merged.count("toc") == 1);
+    CHECK(merged.at("toc").mode == MetaData::Mode::Flag);
+    CHECK(merged.at("toc").firstLocation == FileLocation(6, 0, "test.dml"));
+}
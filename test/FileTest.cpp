@@ -0,0 +1,195 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <algorithm>
+#include <boost/variant/get.hpp>
+#include <docmala/Docmala.h>
+#include <docmala/File.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace docmala;
+
+namespace {
+/**
+ * @brief Counts lines and columns while reading, like the parser did before locations were computed from offsets.
+ */
+std::vector<FileLocation> countLocations(const std::string& data, const FileLocation& base) {
+    std::vector<FileLocation> result;
+    FileLocation              location = base;
+    char                      previous = '\0';
+    for (char c : data) {
+        if (c == '\r') {
+            continue;
+        }
+        if (previous == '\n') {
+            location.line++;
+            location.column = 0;
+        } else {
+            location.column++;
+        }
+        previous = c;
+        result.push_back(location);
+    }
+    return result;
+}
+
+void checkLocations(const std::string& data, const FileLocation& base) {
+    const auto expected = countLocations(data, base);
+
+    MemoryFile                      file(data, base);
+    std::vector<MemoryFile::Offset> offsets;
+    CHECK(file.location() == base);
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        file.getch();
+        INFO("character " << i);
+        CHECK(file.location() == expected[i]);
+        offsets.push_back(file.offset());
+    }
+
+    // offsets are resolved independently of the read position and of each other
+    std::mt19937        random(7);
+    std::vector<size_t> order(offsets.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+
+    MemoryFile fresh(data, base);
+    for (auto i : order) {
+        INFO("offset " << offsets[i]);
+        CHECK(fresh.location(offsets[i]) == expected[i]);
+    }
+    CHECK(fresh.location(-1) == base);
+}
+
+/**
+ * @brief An IFile, that is no MemoryFile, like the ones of callers outside of docmala.
+ */
+class ForwardingFile : public IFile {
+public:
+    ForwardingFile(const std::string& data, const FileLocation& base)
+        : _file(data, base) {}
+
+    bool isOpen() const override {
+        return _file.isOpen();
+    }
+    bool isEoF() const override {
+        return _file.isEoF();
+    }
+    char getch() override {
+        return _file.getch();
+    }
+    char previous() override {
+        return _file.previous();
+    }
+    char following() override {
+        return _file.following();
+    }
+    FileLocation location() const override {
+        return _file.location();
+    }
+    std::string fileName() const override {
+        return _file.fileName();
+    }
+
+private:
+    MemoryFile _file;
+};
+
+std::string describe(const document_part::Text& text) {
+    std::string result = std::to_string(text.location.line) + ":" + std::to_string(text.location.column);
+    for (const auto& part : text.text) {
+        if (const auto formated = boost::get<document_part::FormatedText>(&part)) {
+            result += std::string("|") + (formated->bold ? "b" : "") + (formated->italic ? "i" : "") + formated->text;
+        } else {
+            result += "|?";
+        }
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("MemoryFile::location counts lines and columns") {
+    const FileLocation start(1, 0, "test.dml");
+
+    checkLocations("a", start);
+    checkLocations("abc\ndef\n\nghi", start);
+    checkLocations("\n\nabc\n", start);
+    checkLocations("= Headline\n\nText with [[link]]\n  * list\n", start);
+}
+
+TEST_CASE("MemoryFile::location does not count carriage returns") {
+    const FileLocation start(1, 0, "test.dml");
+
+    checkLocations("abc\r\ndef\r\n\r\nghi", start);
+    checkLocations("a\rb\r\rc\n\rd", start);
+    checkLocations("\r\n\r\n", start);
+}
+
+TEST_CASE("MemoryFile::location continues a base location") {
+    // e.g. the block of a plugin, that starts in the middle of a line of the including file
+    const FileLocation base(12, 7, "outer.dml");
+
+    checkLocations("abc", base);
+    checkLocations("abc\ndef\r\nghi", base);
+    checkLocations("\nabc", base);
+}
+
+TEST_CASE("MemoryFile::location matches counting on random data") {
+    std::mt19937 random(3);
+    const char   alphabet[] = {'a', 'b', ' ', '\n', '\r'};
+
+    for (int iteration = 0; iteration < 50; iteration++) {
+        std::string data(std::uniform_int_distribution<size_t>(1, 300)(random), ' ');
+        for (auto& c : data) {
+            c = alphabet[std::uniform_int_distribution<size_t>(0, sizeof(alphabet) - 1)(random)];
+        }
+        INFO("iteration " << iteration);
+        checkLocations(data, FileLocation(1, 0, "random.dml"));
+    }
+}
+
+TEST_CASE("Docmala::readText reads from any IFile") {
+    const FileLocation base(4, 2, "cell.dml");
+    const std::string  data = "plain **bold** //italic//\nnext line";
+
+    MemoryFile          memoryFile(data, base);
+    document_part::Text expected;
+    std::vector<Error>  expectedErrors;
+    CHECK(Docmala::readText(&memoryFile, expectedErrors, '\0', expected));
+
+    ForwardingFile      file(data, base);
+    IFile*              anyFile = &file;
+    document_part::Text text;
+    std::vector<Error>  errors;
+    CHECK(Docmala::readText(anyFile, errors, '\0', text));
+
+    CHECK(describe(text) == describe(expected));
+    CHECK(errors.size() == expectedErrors.size());
+
+    // the rest of the file is left for the caller
+    CHECK(file.getch() == 'n');
+    CHECK(file.location() == FileLocation(5, 0, "cell.dml"));
+}
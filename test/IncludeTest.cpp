@@ -0,0 +1,131 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <boost/filesystem.hpp>
+#include <docmala/Docmala.h>
+#include <docmala/Document.h>
+#include <fstream>
+#include <string>
+
+using namespace docmala;
+namespace fs = boost::filesystem;
+
+namespace {
+/**
+ * @brief Directory for the files of one test, removed at the end of the test.
+ */
+class TemporaryDirectory {
+public:
+    TemporaryDirectory()
+        : _path(fs::temp_directory_path() / fs::unique_path("docmala_test_%%%%-%%%%-%%%%")) {
+        fs::create_directories(_path);
+    }
+
+    ~TemporaryDirectory() {
+        boost::system::error_code error;
+        fs::remove_all(_path, error);
+    }
+
+    std::string file(const std::string& name) const {
+        return (_path / name).string();
+    }
+
+private:
+    fs::path _path;
+};
+
+void writeFile(const std::string& fileName, const std::string& content) {
+    std::ofstream(fileName, std::ios::out | std::ios::binary | std::ios::trunc) << content;
+}
+
+/**
+ * @brief Messages of the errors and of their extended information, that contain text.
+ */
+size_t countMessages(const std::vector<Error>& errors, const std::string& text) {
+    size_t count = 0;
+    for (const auto& error : errors) {
+        count += error.message.find(text) != std::string::npos ? 1 : 0;
+        for (const auto& info : error.extendedInformation) {
+            count += info.message.find(text) != std::string::npos ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+/**
+ * @return the first link in parts or in the documents and texts they contain, nullptr if there is none
+ */
+const document_part::Link* firstLink(const document_part::PartList& parts) {
+    for (const auto& part : parts) {
+        const document_part::Link* link = nullptr;
+        if (auto doc = boost::get<document_part::GeneratedDocument>(&part)) {
+            link = firstLink(doc->parts());
+        } else if (auto text = boost::get<document_part::Text>(&part)) {
+            link = firstLink(text->text);
+        } else {
+            link = boost::get<document_part::Link>(&part);
+        }
+        if (link != nullptr) {
+            return link;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+TEST_CASE("A recursive include is reported for the includer it is recursive for only") {
+    TemporaryDirectory directory;
+    // x -> a -> b -> x is recursive, a -> b -> x -> a when a is included first
+    writeFile(directory.file("x.dml"), "Text of x.\n\n[include, file=\"a.dml\"]\n");
+    writeFile(directory.file("a.dml"), "Text of a.\n\n[include, file=\"b.dml\"]\n");
+    writeFile(directory.file("b.dml"), "Text of b.\n\n[include, file=\"x.dml\"]\n");
+    writeFile(directory.file("includesX.dml"), "[include, file=\"x.dml\"]\n");
+    writeFile(directory.file("includesA.dml"), "[include, file=\"a.dml\"]\n");
+
+    Docmala includesX;
+    includesX.parseFile(directory.file("includesX.dml"));
+    CHECK(countMessages(includesX.errors(), "Recursive include of file '" + directory.file("x.dml") + "'") == 1);
+
+    Docmala includesA;
+    includesA.parseFile(directory.file("includesA.dml"));
+    CHECK(countMessages(includesA.errors(), "Recursive include of file '" + directory.file("a.dml") + "'") == 1);
+    CHECK(countMessages(includesA.errors(), "Recursive include of file '" + directory.file("x.dml") + "'") == 0);
+}
+
+TEST_CASE("Links rewritten for one include do not change the other includes of the file") {
+    TemporaryDirectory directory;
+    writeFile(directory.file("part.dml"), "[[anchor]]\nSee <<other.dml:anchor, the anchor>>.\n");
+    writeFile(directory.file("includesAsOther.dml"), "[include, file=\"part.dml\", as=other.dml]\n");
+    writeFile(directory.file("includesPart.dml"), "[include, file=\"part.dml\"]\n");
+
+    Docmala includesAsOther;
+    includesAsOther.parseFile(directory.file("includesAsOther.dml"));
+    auto link = firstLink(includesAsOther.document().parts());
+    REQUIRE(link != nullptr);
+    CHECK(link->type == document_part::Link::Type::IntraFile);
+
+    Docmala includesPart;
+    includesPart.parseFile(directory.file("includesPart.dml"));
+    link = firstLink(includesPart.document().parts());
+    REQUIRE(link != nullptr);
+    CHECK(link->type == document_part::Link::Type::InterFile);
+}
@@ -0,0 +1,137 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include "PlantUMLCache.h"
+#include <boost/filesystem.hpp>
+#include <ctime>
+#include <docmala/Hash.h>
+#include <string>
+
+using namespace docmala;
+namespace fs = boost::filesystem;
+
+namespace {
+const std::uint64_t version = 1;
+
+class TemporaryDirectory {
+public:
+    TemporaryDirectory()
+        : _path(fs::temp_directory_path() / fs::unique_path("docmala_test_%%%%-%%%%-%%%%")) {}
+
+    ~TemporaryDirectory() {
+        boost::system::error_code error;
+        fs::remove_all(_path, error);
+    }
+
+    std::string path() const {
+        return _path.string();
+    }
+
+private:
+    fs::path _path;
+};
+
+document_part::String diagram(char c) {
+    return document_part::String(100, c);
+}
+
+bool contains(PlantUMLCache& cache, const std::string& source) {
+    document_part::String data;
+    return cache.load(source, data);
+}
+
+/**
+ * @brief Pretends the entry of source was used seconds ago.
+ */
+void setLastUse(const TemporaryDirectory& directory, const std::string& source, std::time_t secondsAgo) {
+    const auto fileName = directory.path() + "/" + hash::toHex(hash::compute(source, version)) + ".svg";
+    fs::last_write_time(fileName, std::time(nullptr) - secondsAgo);
+}
+
+size_t countFiles(const TemporaryDirectory& directory) {
+    size_t count = 0;
+    for (fs::directory_iterator iter(directory.path()), end; iter != end; ++iter) {
+        count++;
+    }
+    return count;
+}
+} // namespace
+
+TEST_CASE("PlantUMLCache loads stored diagrams") {
+    TemporaryDirectory directory;
+    PlantUMLCache      cache(directory.path(), 1024 * 1024, version);
+
+    document_part::String data;
+    CHECK_FALSE(cache.load("@startuml\nA -> B\n@enduml", data));
+
+    cache.store("@startuml\nA -> B\n@enduml", "<svg>A to B</svg>");
+    REQUIRE(cache.load("@startuml\nA -> B\n@enduml", data));
+    CHECK(data == "<svg>A to B</svg>");
+
+    // no temporary files are left behind
+    CHECK(countFiles(directory) == 1);
+
+    SECTION("by a later run") {
+        PlantUMLCache nextRun(directory.path(), 1024 * 1024, version);
+        CHECK(contains(nextRun, "@startuml\nA -> B\n@enduml"));
+    }
+
+    SECTION("not by another renderer version") {
+        PlantUMLCache otherVersion(directory.path(), 1024 * 1024, version + 1);
+        CHECK_FALSE(contains(otherVersion, "@startuml\nA -> B\n@enduml"));
+    }
+}
+
+TEST_CASE("PlantUMLCache evicts the entries not used for the longest time") {
+    TemporaryDirectory directory;
+    PlantUMLCache      cache(directory.path(), 300, version);
+
+    cache.store("a", diagram('a'));
+    cache.store("b", diagram('b'));
+    cache.store("c", diagram('c'));
+    setLastUse(directory, "a", 30);
+    setLastUse(directory, "b", 20);
+    setLastUse(directory, "c", 10);
+
+    // loading makes a the most recently used entry
+    CHECK(contains(cache, "a"));
+
+    cache.store("d", diagram('d'));
+    CHECK(contains(cache, "a"));
+    CHECK_FALSE(contains(cache, "b"));
+    CHECK_FALSE(contains(cache, "c"));
+    CHECK(contains(cache, "d"));
+}
+
+TEST_CASE("PlantUMLCache counts replaced entries once") {
+    TemporaryDirectory directory;
+    PlantUMLCache      cache(directory.path(), 250, version);
+
+    cache.store("a", diagram('a'));
+    cache.store("b", diagram('b'));
+    for (int i = 0; i < 5; i++) {
+        cache.store("a", diagram('a'));
+    }
+
+    CHECK(contains(cache, "a"));
+    CHECK(contains(cache, "b"));
+}
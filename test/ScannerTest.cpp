@@ -0,0 +1,86 @@
+/**
+    @file
+    @copyright
+        Copyright (C) 2017 Michael Adam
+        Copyright (C) 2017 Bernd Amend
+        Copyright (C) 2017 Stefan Rommel
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU Lesser General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU Lesser General Public License
+        along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "catch.hpp"
+
+#include <algorithm>
+#include <docmala/Scanner.h>
+#include <random>
+#include <string>
+
+using namespace docmala;
+
+namespace {
+const char* findFirstOfReference(const char* begin, const char* end, const std::string& characters) {
+    return std::find_first_of(begin, end, characters.begin(), characters.end());
+}
+} // namespace
+
+TEST_CASE("findFirstOf returns end for an empty range") {
+    const std::string     data = "abc";
+    scanner::CharacterSet characters("a");
+    CHECK(scanner::findFirstOf(data.data(), data.data(), characters) == data.data());
+}
+
+TEST_CASE("findFirstOf finds a character at every position of blocks and tails") {
+    for (const auto& characters : {std::string("\n"), std::string("[]{"), std::string("\0\x80\xff", 3), std::string("0123456789abcdef")}) {
+        scanner::CharacterSet set(characters);
+        for (size_t size = 1; size <= 100; size++) {
+            for (size_t position = 0; position < size; position++) {
+                std::string data(size, 'x');
+                data[position] = characters.back();
+                INFO("characters " << characters.size() << ", size " << size << ", position " << position);
+                CHECK(scanner::findFirstOf(data.data(), data.data() + size, set) == data.data() + position);
+            }
+            const std::string data(size, 'x');
+            CHECK(scanner::findFirstOf(data.data(), data.data() + size, set) == data.data() + size);
+        }
+    }
+}
+
+TEST_CASE("findFirstOf matches the scalar reference on random data") {
+    std::mt19937                       random(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> smallAlphabet(0, 40);
+
+    std::string buffer(512, '\0');
+    for (int iteration = 0; iteration < 2000; iteration++) {
+        // a small alphabet makes matches frequent, bytes above 127 test the signedness of char
+        for (auto& c : buffer) {
+            c = static_cast<char>(iteration % 2 == 0 ? smallAlphabet(random) + 'A' : byte(random));
+        }
+
+        std::string characters;
+        const auto  count = std::uniform_int_distribution<size_t>(1, scanner::CharacterSet::maxSize)(random);
+        for (size_t i = 0; i < count; i++) {
+            characters += static_cast<char>(iteration % 2 == 0 ? smallAlphabet(random) + 'A' : byte(random));
+        }
+        scanner::CharacterSet set(characters);
+
+        // unaligned begin and arbitrary length
+        const auto  offset = std::uniform_int_distribution<size_t>(0, 63)(random);
+        const auto  size   = std::uniform_int_distribution<size_t>(0, buffer.size() - offset)(random);
+        const char* begin  = buffer.data() + offset;
+        const char* end    = begin + size;
+
+        INFO("iteration " << iteration);
+        CHECK(scanner::findFirstOf(begin, end, set) == findFirstOfReference(begin, end, characters));
+    }
+}